@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file aligned_vector.h
+ * @brief Vector with storage aligned for SIMD.
+ */
+#ifndef ALIGNED_VECTOR_H
+#define ALIGNED_VECTOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+// the alignment of the buffers, the width of an AVX-512 register and of a
+// cache line
+#define BUFFER_ALIGNMENT 64
+
+/**
+ * @brief Allocator of memory aligned to BUFFER_ALIGNMENT bytes.
+ * @tparam T The type of the elements.
+ */
+template <typename T>
+class AlignedAllocator {
+ public:
+  using value_type = T;
+
+  AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U>&) noexcept
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_array_new_length();
+    return static_cast<T*>(::operator new(
+        n * sizeof(T), std::align_val_t(BUFFER_ALIGNMENT)));
+  }
+
+  void deallocate(T* p, std::size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(BUFFER_ALIGNMENT));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U>&) const noexcept
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U>&) const noexcept
+  {
+    return false;
+  }
+};
+
+/**
+ * @brief Vector with the data aligned to BUFFER_ALIGNMENT bytes.
+ *
+ * Used for the frames and the DSP buffers, the FFTW plans and the vectorized
+ * loops can then assume aligned data.
+ */
+template <typename T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+#endif  // ALIGNED_VECTOR_H
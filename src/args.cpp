@@ -18,9 +18,15 @@
 #include <iostream>
 #include <set>
 #include <stdexcept>
+#include <string>
 
 #include "args.h"
 
+// the maximum number of worker threads
+#define MAX_JOBS 256
+// the maximum number of frames processed at once
+#define MAX_BLOCK_SIZE 1024
+
 #define REQUIRE_ARG(arg)                                           \
   if (i >= argc) {                                                 \
     throw std::invalid_argument("missing argument for: " + (arg)); \
@@ -57,12 +63,14 @@ struct args parse_args(int argc, char* argv[])
 
   if (cmd == "embed") {
     string_set required{"-sf", "-cf", "-m"};
-    string_set optional{"-mf", "-k", "-l", "-e"};
+    string_set optional{"-mf", "-k", "-l", "-e", "-pc", "-pp", "-j",
+                        "-b", "-P", "-w"};
     parse_opts(args, argc, argv, required, optional);
 
   } else if (cmd == "extract") {
     string_set required{"-sf", "-m"};
-    string_set optional{"-mf", "-k", "-l", "-e"};
+    string_set optional{"-mf", "-k", "-l", "-e", "-pc", "-pp", "-j",
+                        "-b", "-P", "-w"};
     parse_opts(args, argc, argv, required, optional);
   } else if (cmd == "info") {
     if (argc < 3) {
@@ -76,6 +84,21 @@ struct args parse_args(int argc, char* argv[])
       parse_opts(args, argc - 1, argv + 1, required, optional);
     }
     args.coverfile = argv[2];
+  } else if (cmd == "batch") {
+    if (argc < 3) {
+      throw std::invalid_argument("Expected a manifest for batch, see --help");
+    }
+
+    if (argc > 3) {
+      string_set optional{"-j", "-P", "-w"};
+      string_set required;
+      parse_opts(args, argc - 1, argv + 1, required, optional);
+    }
+    args.manifest = argv[2];
+  } else if (cmd == "plan") {
+    string_set required;
+    string_set optional{"-k", "-b", "-P", "-w"};
+    parse_opts(args, argc, argv, required, optional);
   } else {
     throw std::invalid_argument("Unrecognized command: \"" + cmd +
                                 "\", see --help");
@@ -134,6 +157,33 @@ unsigned long parse_limit(const char* limit_str)
   return limit * 8;
 }
 
+unsigned parse_count(const char* str,
+                     unsigned long max,
+                     const std::string& opt)
+{
+  unsigned long count;
+  std::size_t pos;
+  try {
+    count = std::stoul(str, &pos);
+  } catch (const std::exception& e) {
+    throw std::invalid_argument("argument expects a positive number: " + opt);
+  }
+
+  if (str[0] == '-' || str[pos] != '\0' || count == 0 || count > max)
+    throw std::invalid_argument("argument expects a positive number up to " +
+                                std::to_string(max) + ": " + opt);
+  return count;
+}
+
+std::string parse_planner(const char* planner_str)
+{
+  const string_set rigors{"estimate", "measure", "patient", "exhaustive"};
+  if (rigors.find(planner_str) == rigors.end())
+    throw std::invalid_argument(
+        "argument expects one of estimate, measure, patient, exhaustive: -P");
+  return planner_str;
+}
+
 static void parse_opts(struct args& args,
                        int argc,
                        char* argv[],
@@ -176,6 +226,22 @@ static void parse_opts(struct args& args,
       args.limit = parse_limit(argv[i]);
     } else if (arg == "-e") {
       args.use_err_correction = true;
+    } else if (arg == "-pc") {
+      args.parallel_channels = true;
+    } else if (arg == "-pp") {
+      args.pipelined = true;
+    } else if (arg == "-P") {
+      REQUIRE_OPT_ARG(arg);
+      args.planner = parse_planner(argv[i]);
+    } else if (arg == "-w") {
+      REQUIRE_OPT_ARG(arg);
+      args.wisdom = std::string(argv[i]);
+    } else if (arg == "-j") {
+      REQUIRE_OPT_ARG(arg);
+      args.jobs = parse_count(argv[i], MAX_JOBS, "-j");
+    } else if (arg == "-b") {
+      REQUIRE_OPT_ARG(arg);
+      args.block_size = parse_count(argv[i], MAX_BLOCK_SIZE, "-b");
     } else {
       throw std::invalid_argument("unknown option: " + arg);
     }
@@ -185,4 +251,12 @@ static void parse_opts(struct args& args,
     std::string arg = *required.begin();
     throw std::invalid_argument("Required argument not given: " + arg);
   }
+
+  if (args.parallel_channels + args.pipelined + args.jobs.has_value() > 1) {
+    throw std::invalid_argument("options -pc, -pp and -j can't be combined");
+  }
+
+  if (args.block_size && (args.parallel_channels || args.jobs)) {
+    throw std::invalid_argument("option -b can't be combined with -pc or -j");
+  }
 }
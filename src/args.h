@@ -36,6 +36,13 @@ struct args {
   std::optional<std::string> msgfile = std::nullopt;
   std::optional<unsigned long> limit = std::nullopt;  // in bits
   bool use_err_correction = false;
+  bool parallel_channels = false;
+  bool pipelined = false;
+  std::optional<unsigned> jobs = std::nullopt;
+  std::optional<unsigned> block_size = std::nullopt;  // in frames
+  std::optional<std::string> manifest = std::nullopt;
+  std::optional<std::string> planner = std::nullopt;
+  std::optional<std::string> wisdom = std::nullopt;
 };
 
 /**
@@ -23,35 +23,88 @@
 #include "fft.h"
 #include "util.h"
 
-Autocepstrum::Autocepstrum(std::vector<double>& in,
-                                 std::vector<double>& out)
+template <typename T>
+Autocepstrum<T>::Autocepstrum(aligned_vector<T>& in, aligned_vector<T>& out)
     : in(&in),
       out(&out),
       padded_size(pow(2, next_pow2(2 * in.size() - 1))),
       padded_in(padded_size, 0),
-      dft(padded_size),
+      dft(padded_size / 2 + 1),
+      log_spectrum(padded_size / 2 + 1),
       fft(padded_size, padded_in, dft),
-      ifft(padded_size, dft, out)
+      dct(padded_size / 2 + 1, log_spectrum, out)
 {
 }
 
-void Autocepstrum::exec()
+template <typename T>
+void Autocepstrum<T>::select_lags(const std::vector<std::size_t>& lags)
+{
+  const std::size_t half = padded_size / 2;
+
+  this->lags = lags;
+  cos_tables.clear();
+
+  // The log spectrum is real and even, so the inverse DFT reduces to a cosine
+  // series over the first half of the spectrum. The tables also hold the
+  // weights of the individual bins and the normalization.
+  for (std::size_t lag : lags) {
+    aligned_vector<T> table(half + 1);
+    table[0] = 1.0 / padded_size;
+    for (std::size_t k = 1; k < half; k++) {
+      table[k] = 2 * std::cos(2 * M_PI * k * lag / padded_size) / padded_size;
+    }
+    table[half] = (lag % 2 ? -1.0 : 1.0) / padded_size;
+    cos_tables.push_back(std::move(table));
+  }
+}
+
+template <typename T>
+void Autocepstrum<T>::exec()
 {
   // pad with zeroes to avoid circular convolution
   std::copy(in->begin(), in->end(), padded_in.begin());
 
   fft.exec();
+  analyze(dft.data());
+}
 
-  // autocorrelation
-  for (std::size_t i = 0; i < dft.size(); i++) {
-    dft[i] *= std::conj(dft[i]);
+template <typename T>
+void Autocepstrum<T>::analyze(const std::complex<T>* spectrum)
+{
+  // the power spectrum is the spectrum of the autocorrelation, only the first
+  // half is needed as the spectrum of a real signal is symmetric
+  for (std::size_t k = 0; k < log_spectrum.size(); k++) {
+    const T re = spectrum[k].real();
+    const T im = spectrum[k].imag();
+    log_spectrum[k] = std::log(re * re + im * im);
   }
 
-  // cepstrum
-  for (std::size_t i = 0; i < dft.size(); i++) {
-    const auto abs = std::complex<double>(std::abs(dft[i]), 0);
-    dft[i] = std::log(abs);
+  if (!lags.empty()) {
+    // cepstrum, only for the selected lags
+    for (std::size_t i = 0; i < lags.size(); i++) {
+      const aligned_vector<T>& table = cos_tables[i];
+      T coef = 0;
+      for (std::size_t k = 0; k < log_spectrum.size(); k++) {
+        coef += table[k] * log_spectrum[k];
+      }
+      (*out)[lags[i]] = coef;
+    }
+    return;
   }
 
-  ifft.exec();
+  // cepstrum, the log spectrum is real and even, so its inverse DFT is the
+  // DCT-I of its first half
+  dct.exec();
+
+  const std::size_t half = padded_size / 2;
+  for (std::size_t i = 0; i <= half; i++) {
+    (*out)[i] /= padded_size;
+  }
+  // the second half of the cepstrum is symmetric with the first
+  for (std::size_t i = 1; i < half; i++) {
+    (*out)[padded_size - i] = (*out)[i];
+  }
 }
+
+template class Autocepstrum<double>;
+template class Autocepstrum<float>;
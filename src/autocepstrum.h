@@ -17,27 +17,32 @@
 #ifndef AUTOCORRELATION_H
 #define AUTOCORRELATION_H
 
+#include <complex>
 #include <vector>
 
+#include "aligned_vector.h"
+#include "dct.h"
 #include "fft.h"
-#include "ifft.h"
 
 /**
  * @brief The algorithm for computing the autocepstrum.
  *
  * This algorithm computes the real autocepstrum -- the real cepstrum of
  * an autocorrelation of a signal.
+ * @tparam T The precision of the samples, double or float.
  */
+template <typename T>
 class Autocepstrum {
  public:
   /**
    * @brief Constructor.
    * Create a new Autocepstrum object with the associated input and output
-   * buffers. The size of the output buffer must be at least 2 * in.size() - 1.
+   * buffers. The size of the output buffer must be at least 2 * in.size() - 1
+   * rounded up to the next power of 2.
    * @param in The input signal buffer.
    * @param out The output buffer,
    */
-  Autocepstrum(std::vector<double>& in, std::vector<double>& out);
+  Autocepstrum(aligned_vector<T>& in, aligned_vector<T>& out);
 
   /**
    * @brief Computes the autocepstrum.
@@ -46,17 +51,48 @@ class Autocepstrum {
    */
   void exec();
 
+  /**
+   * @brief Computes the autocepstrum from an already transformed input.
+   * The output is written to output buffer.
+   * @param spectrum The spectrum of the input signal zero-padded to
+   * transform_size(), at least transform_size() / 2 + 1 long.
+   */
+  void analyze(const std::complex<T>* spectrum);
+
+  /**
+   * @brief Get the length of the transform.
+   * @return The length the input signal is zero-padded to.
+   */
+  std::size_t transform_size() const { return padded_size; }
+
+  /**
+   * @brief Compute only the given lags.
+   * After this call exec() computes only the given coefficients of the
+   * autocepstrum directly from the log spectrum, instead of the full inverse
+   * FFT. The other values of the output buffer are left untouched. An empty
+   * list restores computing all of the coefficients.
+   * @param lags The indices of the coefficients to compute.
+   */
+  void select_lags(const std::vector<std::size_t>& lags);
+
  private:
-  const std::vector<double>* in;
-  std::vector<double>* out;
+  const aligned_vector<T>* in;
+  aligned_vector<T>* out;
 
   size_t padded_size;
-  std::vector<double> padded_in;
+  aligned_vector<T> padded_in;
+
+  aligned_vector<std::complex<T>> dft;
+
+  // the selected lags and the cosine tables used to compute them
+  std::vector<std::size_t> lags;
+  std::vector<aligned_vector<T>> cos_tables;
 
-  std::vector<std::complex<double>> dft;
+  // the first half of the log power spectrum
+  aligned_vector<T> log_spectrum;
 
-  FFT fft;
-  IFFT ifft;
+  FFT<T> fft;
+  DCT<T> dct;
 };
 
 #endif
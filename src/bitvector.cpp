@@ -14,6 +14,8 @@
  * You should have received a copy of the GNU General Public License along with
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#include <algorithm>
+
 #include "bitvector.h"
 
 #define BIT_IDX(n) ((n) % 8)
@@ -116,6 +118,13 @@ void BitVector::append(const uint32_t v, unsigned char n)
   }
 }
 
+void BitVector::append(const uint64_t v, unsigned char n)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    _append((v >> i) & 1);
+  }
+}
+
 void BitVector::append(const BitVector& v)
 {
   for (std::size_t i = 0; i < v.size(); i++) {
@@ -145,12 +154,17 @@ std::vector<uint8_t>& BitVector::to_bytes()
   return data;
 }
 
-uint64_t BitVector::read(std::size_t from, int n)
+uint64_t BitVector::read(std::size_t from, int n) const
 {
-  assert(n < 64);
+  assert(n >= 0 && n <= 64 && from + n <= _size);
   uint64_t ret = 0;
-  for (std::size_t i = from; i < n + from; i++) {
-    ret |= ((uint64_t)_get(i) << i);
+  // the rest of each byte at once
+  for (int got = 0; got < n;) {
+    const std::size_t i = from + got;
+    const int take = std::min(n - got, 8 - (int)BIT_IDX(i));
+    const uint64_t bits = data[BYTE_IDX(i)] >> BIT_IDX(i);
+    ret |= (bits & ((1u << take) - 1)) << got;
+    got += take;
   }
   return ret;
 }
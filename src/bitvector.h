@@ -71,7 +71,13 @@ class BitVector {
 
   std::vector<uint8_t> to_bytes(std::size_t from) const;
 
-  uint64_t read(std::size_t from, int n);
+  /**
+   * @brief Read the bits from the given one on.
+   * @param from The index of the first bit.
+   * @param n The number of bits, at most 64.
+   * @return The bits, the first one the least significant.
+   */
+  uint64_t read(std::size_t from, int n) const;
 
   void clear();
 
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CHANNEL_BATCH_H
+#define CHANNEL_BATCH_H
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <memory>
+
+#include "aligned_vector.h"
+#include "fft.h"
+#include "ifft.h"
+
+/**
+ * @brief The transforms of a block of frames, computed at once.
+ *
+ * The frames, e.g. of all channels, are zero-padded to the length of the
+ * transform and transformed by a single batched FFT, the spectra can be
+ * transformed back by a single batched inverse FFT. The buffers and the
+ * transforms are sized for the largest number of frames so far, fewer frames,
+ * e.g. of the shorter last block of a file, reuse them instead of planning new
+ * transforms.
+ * @tparam T The precision of the samples, double or float.
+ */
+template <typename T>
+class ChannelBatch {
+ public:
+  /**
+   * @brief Constructor.
+   * @param frame_size The length of the frames.
+   * @param size The length of the transforms, at least frame_size.
+   * @param spectrum_size The distance between the spectra of the frames,
+   * at least size / 2 + 1.
+   * @param inverse Whether the inverse transforms are used.
+   */
+  ChannelBatch(std::size_t frame_size,
+               std::size_t size,
+               std::size_t spectrum_size,
+               bool inverse)
+      : frame_size(frame_size),
+        size(size),
+        spectrum_size(spectrum_size),
+        use_inverse(inverse)
+  {
+  }
+
+  /**
+   * @brief Transform the frames.
+   * @param block The frames, one after another.
+   * @param count The number of frames.
+   */
+  void forward(const T* block, unsigned count)
+  {
+    resize(count);
+    for (unsigned i = 0; i < count; i++) {
+      const T* frame = block + i * frame_size;
+      std::copy(frame, frame + frame_size, input.begin() + i * size);
+    }
+    fft->exec();
+  }
+
+  /**
+   * @brief Transform the spectra back and write the first frames to the
+   * block.
+   *
+   * The spectra are destroyed by the transform.
+   * @param block The frames, one after another.
+   * @param count The number of frames to write.
+   */
+  void inverse(T* block, unsigned count)
+  {
+    ifft->exec();
+    for (unsigned i = 0; i < count; i++) {
+      const T* frame = output.data() + i * size;
+      std::copy(frame, frame + frame_size, block + i * frame_size);
+    }
+  }
+
+  /**
+   * @brief Get the spectrum of the given frame.
+   */
+  std::complex<T>* spectrum(unsigned i)
+  {
+    return spectra.data() + i * spectrum_size;
+  }
+
+  /**
+   * @brief Get the given frame passed to forward().
+   */
+  const T* frame(unsigned i) const { return input.data() + i * size; }
+
+ private:
+  void resize(unsigned count)
+  {
+    if (count <= this->count)
+      return;
+
+    // the transforms are planned for the final sizes of the buffers
+    input.assign(count * size, 0);
+    spectra.assign(count * spectrum_size, 0);
+    fft = std::make_unique<FFT<T>>(size, input, spectra, count);
+    if (use_inverse) {
+      output.assign(count * size, 0);
+      ifft = std::make_unique<IFFT<T>>(size, spectra, output, count);
+    }
+    this->count = count;
+  }
+
+  std::size_t frame_size;
+  std::size_t size;
+  std::size_t spectrum_size;
+  bool use_inverse;
+
+  unsigned count = 0;
+  aligned_vector<T> input;
+  aligned_vector<std::complex<T>> spectra;
+  aligned_vector<T> output;
+  std::unique_ptr<FFT<T>> fft;
+  std::unique_ptr<IFFT<T>> ifft;
+};
+
+#endif  // CHANNEL_BATCH_H
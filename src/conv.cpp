@@ -22,48 +22,129 @@
 
 using namespace std;
 
-Conv::Conv(vector<double>& x, vector<double>& filter, vector<double>& out)
+template <typename T>
+MultiConv<T>::MultiConv(aligned_vector<T>& x,
+                        std::size_t filter_len,
+                        std::size_t n_filters)
     : x(x),
-      filter(filter),
-      out(out),
-      conv_size(x.size() + filter.size() - 1),
+      conv_size(x.size() + filter_len - 1),
       padded_size(pow(2, next_pow2(conv_size))),
       padded_x(padded_size, 0),
       padded_filter(padded_size, 0),
-      olap_len(conv_size - x.size()),
-      olap(olap_len, 0),
       dft_x(padded_size),
       dft_filter(padded_size),
       fft_x(padded_size, padded_x, dft_x),
       fft_filter(padded_size, padded_filter, dft_filter),
-      ifft(padded_size, dft_filter, out)
+      spectra(n_filters),
+      filters(n_filters, nullptr),
+      dft_out(n_filters * padded_size),
+      out(n_filters * padded_size, 0),
+      olap(n_filters, aligned_vector<T>(conv_size - x.size(), 0)),
+      ifft(padded_size, dft_out, out, n_filters)
 {
 }
 
-void Conv::exec()
+template <typename T>
+void MultiConv<T>::set_filter(std::size_t k, const aligned_vector<T>& filter)
 {
-  std::copy(x.begin(), x.end(), padded_x.begin());
+  transform(filter, spectra[k]);
+  filters[k] = &spectra[k];
+}
+
+template <typename T>
+void MultiConv<T>::set_spectrum(std::size_t k,
+                                const aligned_vector<complex<T>>& spectrum)
+{
+  filters[k] = &spectrum;
+}
+
+template <typename T>
+void MultiConv<T>::transform(const aligned_vector<T>& filter,
+                             aligned_vector<complex<T>>& spectrum)
+{
+  std::fill(padded_filter.begin(), padded_filter.end(), 0);
   std::copy(filter.begin(), filter.end(), padded_filter.begin());
+  fft_filter.exec();
+  spectrum = dft_filter;
+}
 
+template <typename T>
+void MultiConv<T>::exec()
+{
+  std::copy(x.begin(), x.end(), padded_x.begin());
   fft_x.exec();
-  fft_filter.exec();
+  convolve(dft_x.data());
+}
+
+template <typename T>
+void MultiConv<T>::convolve(const complex<T>* spectrum)
+{
+  for (std::size_t k = 0; k < filters.size(); k++) {
+    const aligned_vector<complex<T>>& filter = *filters[k];
+    complex<T>* dft = dft_out.data() + k * padded_size;
 
-  // the actual convolution
-  for (std::size_t i = 0; i < conv_size; i++) {
-    // reuse the dft_kernel for the convolution in freq domain
-    dft_filter[i] = dft_x[i] * dft_filter[i];
+    // the actual convolution
+    for (std::size_t i = 0; i < padded_size / 2 + 1; i++) {
+      dft[i] = spectrum[i] * filter[i];
+    }
   }
 
   ifft.exec();
 
-  // overlap add from previous segment
-  for (std::size_t i = 0; i < olap_len; i++) {
-    (out)[i] += olap[i];
+  for (std::size_t k = 0; k < filters.size(); k++) {
+    T* y = out.data() + k * padded_size;
+
+    // overlap add from previous segment
+    for (std::size_t i = 0; i < olap[k].size(); i++) {
+      y[i] += olap[k][i];
+    }
+
+    // save overlap for next segment
+    std::copy(y + x.size(), y + conv_size, olap[k].begin());
+  }
+}
+
+template <typename T>
+SparseConv<T>::SparseConv(aligned_vector<T>& x,
+                          const aligned_vector<T>& filter,
+                          aligned_vector<T>& out)
+    : x(x), out(out), history(filter.empty() ? 0 : filter.size() - 1, 0)
+{
+  for (std::size_t i = 0; i < filter.size(); i++) {
+    if (filter[i] != 0)
+      taps.emplace_back(i, filter[i]);
+  }
+}
+
+template <typename T>
+void SparseConv<T>::exec()
+{
+  const std::size_t n = x.size();
+  const std::size_t hist_len = history.size();
+
+  std::fill(out.begin(), out.begin() + n, 0);
+
+  for (const auto& [delay, gain] : taps) {
+    // the samples reaching back to the previous input
+    const std::size_t split = std::min(delay, n);
+    for (std::size_t i = 0; i < split; i++) {
+      out[i] += gain * history[hist_len - delay + i];
+    }
+    for (std::size_t i = split; i < n; i++) {
+      out[i] += gain * x[i - delay];
+    }
   }
 
-  // save overlap for next segment
-  int j = 0;
-  for (std::size_t i = x.size(); i < conv_size; i++) {
-    olap[j++] = (out)[i];
+  // update the delay line
+  if (hist_len > n) {
+    std::move(history.begin() + n, history.end(), history.begin());
+    std::copy(x.begin(), x.end(), history.end() - n);
+  } else {
+    std::copy(x.end() - hist_len, x.end(), history.begin());
   }
 }
+
+template class MultiConv<double>;
+template class MultiConv<float>;
+template class SparseConv<double>;
+template class SparseConv<float>;
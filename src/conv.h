@@ -17,54 +17,163 @@
 #ifndef CONV_H
 #define CONV_H
 
+#include <complex>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "aligned_vector.h"
 #include "fft.h"
 #include "ifft.h"
 
 /**
- * @brief The convolution algorithm.
- * This algorithm computes convolution of input signal with a filter. The actual
- * computation happens in frequency domain with FFT. Overlapping of samples is
- * handled using the Overlap-Add method.
+ * @brief The convolution algorithm for multiple filters.
+ * This algorithm computes convolutions of one input signal with several
+ * filters. The input signal is transformed only once and shared by all of the
+ * filters. Overlapping of samples is handled using the Overlap-Add method,
+ * separately for each filter.
+ *
+ * The filters are given as spectra, either transformed by set_filter() or
+ * precomputed with transform() and assigned by set_spectrum(). This allows
+ * switching between a fixed set of filters without transforming them again.
+ * @tparam T The precision of the samples, double or float.
  */
-class Conv {
+template <typename T>
+class MultiConv {
  public:
   /**
    * @brief Constructor.
    * @param x The buffer for the signal to filter.
-   * @param filter The filter buffer.
-   * @param out The output buffer.
+   * @param filter_len The maximum length of the filters.
+   * @param n_filters The number of filters.
    */
-  Conv(std::vector<double>& x,
-       std::vector<double>& filter,
-       std::vector<double>& out);
+  MultiConv(aligned_vector<T>& x,
+            std::size_t filter_len,
+            std::size_t n_filters);
 
   /**
-   * @brief Run the algorithm with inputs and outputs in the respective buffers.
+   * @brief Transform and set the filter.
+   * @param k The index of the filter.
+   * @param filter The filter, at most filter_len long.
+   */
+  void set_filter(std::size_t k, const aligned_vector<T>& filter);
+
+  /**
+   * @brief Set the filter spectrum.
+   * The spectrum is not copied, it must outlive all calls to exec() using it.
+   * @param k The index of the filter.
+   * @param spectrum The spectrum of the filter as computed by transform().
+   */
+  void set_spectrum(std::size_t k,
+                    const aligned_vector<std::complex<T>>& spectrum);
+
+  /**
+   * @brief Compute the spectrum of a filter.
+   * @param filter The filter, at most filter_len long.
+   * @param spectrum The buffer for the spectrum, resized as needed.
+   */
+  void transform(const aligned_vector<T>& filter,
+                 aligned_vector<std::complex<T>>& spectrum);
+
+  /**
+   * @brief Run the algorithm for all filters.
    */
   void exec();
 
+  /**
+   * @brief Run the algorithm for all filters on an already transformed input.
+   * The outputs of all filters are transformed back by a single batched
+   * inverse FFT.
+   * @param spectrum The spectrum of the zero-padded input signal, at least
+   * padded_size() / 2 + 1 long.
+   */
+  void convolve(const std::complex<T>* spectrum);
+
+  /**
+   * @brief Get the output for the given filter.
+   * Only the first x.size() samples are valid.
+   * @param k The index of the filter.
+   * @return The output buffer.
+   */
+  const T* output(std::size_t k) const
+  {
+    return out.data() + k * padded_size;
+  }
+
+  /**
+   * @brief Get the length of the transforms.
+   * @return The length the input signal is zero-padded to.
+   */
+  std::size_t transform_size() const { return padded_size; }
+
  private:
-  std::vector<double>& x;
-  std::vector<double>& filter;
-  std::vector<double>& out;
+  aligned_vector<T>& x;
 
   std::size_t conv_size;  // the actual convolution size
   std::size_t padded_size;
-  std::vector<double> padded_x;
-  std::vector<double> padded_filter;
+  aligned_vector<T> padded_x;
+  aligned_vector<T> padded_filter;
+
+  aligned_vector<std::complex<T>> dft_x;
+  aligned_vector<std::complex<T>> dft_filter;
 
-  std::size_t olap_len;
+  FFT<T> fft_x;
+  FFT<T> fft_filter;
+
+  // the filter spectra set by set_filter()
+  std::vector<aligned_vector<std::complex<T>>> spectra;
+  // the filter spectra used by exec()
+  std::vector<const aligned_vector<std::complex<T>>*> filters;
+
+  // the spectra and outputs of all filters, one after another
+  aligned_vector<std::complex<T>> dft_out;
+  aligned_vector<T> out;
   // overlap-add history
-  std::vector<double> olap;
+  std::vector<aligned_vector<T>> olap;
+
+  IFFT<T> ifft;
+};
+
+/**
+ * @brief The convolution algorithm for sparse filters.
+ * This algorithm computes convolution of input signal with a filter in time
+ * domain. Only the non-zero taps of the filter are evaluated, so the cost is
+ * proportional to the number of taps instead of the length of the filter. The input samples needed by
+ * the next call are kept in a delay line.
+ *
+ * The non-zero taps are collected in the constructor, the filter must not be
+ * modified afterwards.
+ * @tparam T The precision of the samples, double or float.
+ */
+template <typename T>
+class SparseConv {
+ public:
+  /**
+   * @brief Constructor.
+   * @param x The buffer for the signal to filter.
+   * @param filter The filter buffer.
+   * @param out The output buffer, must be at least as long as x.
+   */
+  SparseConv(aligned_vector<T>& x,
+             const aligned_vector<T>& filter,
+             aligned_vector<T>& out);
+
+  /**
+   * @brief Run the algorithm with inputs and outputs in the respective buffers.
+   *
+   * Only the first x.size() samples of the output buffer are written.
+   */
+  void exec();
+
+ private:
+  aligned_vector<T>& x;
+  aligned_vector<T>& out;
 
-  std::vector<std::complex<double>> dft_x;
-  std::vector<std::complex<double>> dft_filter;
+  // the non-zero taps as (delay, gain) pairs
+  std::vector<std::pair<std::size_t, T>> taps;
 
-  FFT fft_x;
-  FFT fft_filter;
-  IFFT ifft;
+  // the last samples of the previous input
+  aligned_vector<T> history;
 };
 
 #endif
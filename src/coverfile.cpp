@@ -35,3 +35,18 @@ AudioParams CoverFile::audio_params()
 {
   return AudioParams(cover);
 }
+
+SndfileHandle CoverFile::open_stego(const std::string& stegofile)
+{
+  SndfileHandle stego{stegofile, SFM_WRITE, cover.format(), cover.channels(),
+                      cover.samplerate()};
+  if (!stego) {
+    std::stringstream msg;
+    msg << "Failed to open file " << stegofile << ": ";
+    msg << stego.strError() << std::endl;
+    throw IOException(msg.str());
+  }
+
+  stego.command(SFC_SET_CLIPPING, NULL, SF_TRUE);
+  return stego;
+}
@@ -17,15 +17,25 @@
 #ifndef COVERFILE_H
 #define COVERFILE_H
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <sndfile.hh>
 
 #include "audioparams.h"
+#include "bitvector.h"
 #include "dsp_utils.h"
 #include "embedder.h"
+#include "ibitstream.h"
 #include "ioexception.h"
+#include "planar_block.h"
+#include "spsc_queue.h"
+#include "stage_thread.h"
+#include "thread_pool.h"
 
 /**
  * @brief Cover file for steganography.
@@ -49,40 +59,301 @@ class CoverFile {
    * @brief Embed data into the file with the given embedder
    * @params stegofile The filename of the resulting stego file.
    * @params embedder The embedder to embed data with.
+   * @params block_size The number of frames embedded into at once.
    */
   template <typename T>
   void embed(const std::string& stegofile,
              Embedder<T>& embedder,
-             InBitStream& bs)
+             InBitStream& bs,
+             std::size_t block_size = DEF_BLOCK_FRAMES)
   {
-    SndfileHandle stego{stegofile, SFM_WRITE, cover.format(), cover.channels(),
-                        cover.samplerate()};
-    if (!stego) {
-      std::stringstream msg;
-      msg << "Failed to open file " << stegofile << ": ";
-      msg << stego.strError() << std::endl;
-      throw IOException(msg.str());
+    SndfileHandle stego = open_stego(stegofile);
+    const int channels = cover.channels();
+    const std::size_t frame_size = embedder.frame_size();
+    aligned_vector<T> buffer(block_size * frame_size * channels);
+    PlanarBuffer<T> planar(block_size, frame_size, channels);
+
+    sf_count_t read = 0;
+    bool done = false;
+    while ((read = cover.readf(buffer.data(), block_size * frame_size)) > 0) {
+      // safe cast, read is > 0, only whole frames are embedded into
+      const std::size_t frames = (std::size_t)read / frame_size;
+      if (!done && frames > 0) {
+        const PlanarBlock<T> block = planar.load(buffer.data(), frames);
+        done = embedder.embed_frames(block);
+        planar.store(block, buffer.data());
+      }
+      stego.writef(buffer.data(), read);
+    }
+  }
+
+  /**
+   * @brief Embed data into the file with one embedder per channel.
+   *
+   * Each channel is processed by its own embedder on a pool of one thread per
+   * channel, an exception of any of them is rethrown after all channels of
+   * the chunk are processed. The bits of the message are distributed among
+   * the channels in advance, the i-th bit is embedded into the channel
+   * i % channels. The data must be extracted with
+   * StegoFile::extract_channels().
+   * @params stegofile The filename of the resulting stego file.
+   * @params make_embedder A function creating an embedder for the given
+   * input bit stream.
+   * @params bs The bit stream with the data to embed.
+   */
+  template <typename Factory>
+  void embed_channels(const std::string& stegofile,
+                      Factory make_embedder,
+                      InBitStream& bs)
+  {
+    using T = typename decltype(make_embedder(bs))::element_type::sample_type;
+
+    SndfileHandle stego = open_stego(stegofile);
+    const int channels = cover.channels();
+
+    std::vector<BitVector> channel_bits(channels);
+    int bit;
+    for (std::size_t i = 0; (bit = bs.next_bit()) != EOF; i++) {
+      channel_bits[i % channels].push_back(bit);
+    }
+
+    std::vector<std::unique_ptr<VectorInBitStream>> streams;
+    std::vector<std::unique_ptr<Embedder<T>>> embedders;
+    for (int ch = 0; ch < channels; ch++) {
+      streams.push_back(std::make_unique<VectorInBitStream>(channel_bits[ch]));
+      embedders.push_back(make_embedder(*streams.back()));
     }
 
-    stego.command(SFC_SET_CLIPPING, NULL, SF_TRUE);
-    std::vector<T> buffer(embedder.frame_size() * cover.channels());
+    const std::size_t frame_size = embedders[0]->frame_size();
+    std::vector<T> buffer(CHANNEL_BLOCK_FRAMES * frame_size * channels);
+    std::vector<char> done(channels, false);
+    ThreadPool pool(channels);
 
     sf_count_t read = 0;
+    while ((read = cover.readf(buffer.data(),
+                               CHANNEL_BLOCK_FRAMES * frame_size)) > 0) {
+      // safe cast, read is > 0, only whole frames are embedded into
+      const std::size_t frames = (std::size_t)read / frame_size;
+
+      pool.run_all(channels, [&](std::size_t ch) {
+        Embedder<T>& embedder = *embedders[ch];
+        for (std::size_t f = 0; f < frames && !done[ch]; f++) {
+          T* frame = buffer.data() + f * frame_size * channels;
+          demultiplex(frame, embedder.input().data(), frame_size, ch,
+                      channels);
+          done[ch] = embedder.embed();
+          multiplex(embedder.output().data(), frame, frame_size, ch,
+                    channels);
+        }
+      });
+      stego.writef(buffer.data(), read);
+    }
+  }
+
+  /**
+   * @brief Embed data into the file, overlapping decoding, embedding and
+   * encoding.
+   *
+   * The cover file is read by a reader thread and the stego file written by a
+   * writer thread, while the embedding runs on the calling thread. The stages
+   * pass blocks of frames through lock-free queues, so the total time
+   * approaches the time of the slowest stage. An exception of any stage stops
+   * the others and is rethrown here. The result is the same as with embed().
+   * @params stegofile The filename of the resulting stego file.
+   * @params embedder The Embedder to embed data with.
+   * @params block_size The number of frames in each block.
+   */
+  template <typename T>
+  void embed_pipelined(const std::string& stegofile,
+                       Embedder<T>& embedder,
+                       std::size_t block_size = PIPELINE_BLOCK_FRAMES)
+  {
+    SndfileHandle stego = open_stego(stegofile);
+    const int channels = cover.channels();
+    const std::size_t frame_size = embedder.frame_size();
+    const sf_count_t block_frames = block_size * frame_size;
+
+    std::vector<aligned_vector<T>> blocks(
+        PIPELINE_BLOCKS, aligned_vector<T>(block_frames * channels));
+    std::vector<sf_count_t> read(PIPELINE_BLOCKS);
+
+    // the blocks are passed around by their indices
+    SpscQueue<std::size_t> free_blocks(PIPELINE_BLOCKS);
+    SpscQueue<std::size_t> filled_blocks(PIPELINE_BLOCKS);
+    SpscQueue<std::size_t> processed_blocks(PIPELINE_BLOCKS);
+    for (std::size_t i = 0; i < PIPELINE_BLOCKS; i++) {
+      free_blocks.push(i);
+    }
+
+    // set when any stage fails, cancels the waits of the others
+    std::atomic<bool> stop{false};
+    // a block with nothing read marks the end of the file
+    StageThread reader(stop, [&] {
+      std::size_t i;
+      do {
+        if (!free_blocks.pop(i, &stop))
+          return;
+        read[i] = cover.readf(blocks[i].data(), block_frames);
+        filled_blocks.push(i);
+      } while (read[i] > 0);
+    });
+
+    StageThread writer(stop, [&] {
+      std::size_t i;
+      while (processed_blocks.pop(i, &stop) && read[i] > 0) {
+        stego.writef(blocks[i].data(), read[i]);
+        free_blocks.push(i);
+      }
+    });
+
+    PlanarBuffer<T> planar(block_size, frame_size, channels);
+
     bool done = false;
-    while ((read = cover.readf(buffer.data(), embedder.frame_size())) > 0) {
-      for (int ch = 0; ch < stego.channels(); ch++) {
-        // safe cast, read is > 0
-        if (done || (unsigned)read != embedder.frame_size())
-          break;
-        demultiplex(buffer, embedder.input(), ch, stego.channels());
-        done = embedder.embed();
-        multiplex(embedder.output(), buffer, ch, stego.channels());
+    std::size_t i;
+    // the queues never hold more than all blocks, the pushes never wait
+    while (filled_blocks.pop(i, &stop)) {
+      // the block with nothing read is passed on to end the writer
+      if (read[i] > 0) {
+        // safe cast, read is > 0, only whole frames are embedded into
+        const std::size_t frames = (std::size_t)read[i] / frame_size;
+        if (!done && frames > 0) {
+          const PlanarBlock<T> block = planar.load(blocks[i].data(), frames);
+          done = embedder.embed_frames(block);
+          planar.store(block, blocks[i].data());
+        }
       }
-      stego.writef(buffer.data(), read);
+      processed_blocks.push(i);
+      if (read[i] <= 0)
+        break;
+    }
+
+    reader.join();
+    writer.join();
+  }
+
+  /**
+   * @brief Embed data into the file by segments in parallel.
+   *
+   * The file is read in chunks, the frames of each chunk are split into
+   * contiguous segments, one for each thread of a pool. Every worker has its
+   * own embedder reading the message from the position of its first frame.
+   * This only works for methods embedding the same number of bits into each
+   * frame, see Method::frame_bits(). The state the embedder carries from the
+   * preceding frames is restored by a new embedder warming up on the
+   * preceding frames, with its output discarded, see Method::embed_warmup().
+   * An exception of any worker is rethrown after all segments of the chunk
+   * are processed. The result is the same as with embed().
+   * @params stegofile The filename of the resulting stego file.
+   * @params make_embedder A function creating an embedder for the given
+   * input bit stream.
+   * @params bs The bit stream with the data to embed.
+   * @params frame_bits The number of bits embedded into each frame.
+   * @params warmup The number of frames to warm up on.
+   * @params jobs The number of worker threads.
+   */
+  template <typename Factory>
+  void embed_segments(const std::string& stegofile,
+                      Factory make_embedder,
+                      InBitStream& bs,
+                      std::size_t frame_bits,
+                      std::size_t warmup,
+                      unsigned jobs)
+  {
+    using T = typename decltype(make_embedder(bs))::element_type::sample_type;
+
+    SndfileHandle stego = open_stego(stegofile);
+    const int channels = cover.channels();
+
+    BitVector message;
+    int bit;
+    while ((bit = bs.next_bit()) != EOF) {
+      message.push_back(bit);
+    }
+
+    std::vector<std::unique_ptr<SeekableInBitStream>> streams;
+    std::vector<std::unique_ptr<Embedder<T>>> embedders;
+    for (unsigned w = 0; w < jobs; w++) {
+      streams.push_back(std::make_unique<SeekableInBitStream>(message));
+      embedders.push_back(make_embedder(*streams.back()));
+    }
+
+    // the frames are embedded into one channel after another, so the frames
+    // to warm up on may be the other channels of the same frame
+    const std::size_t frame_size = embedders[0]->frame_size();
+    const std::size_t chunk_frames = jobs * SEGMENT_BLOCK_FRAMES;
+    // the preceding multichannel frames kept for the warm up
+    const std::size_t history = (warmup + channels - 1) / channels;
+    const std::size_t frame_len = frame_size * channels;
+
+    // the input is kept intact, the warm up may read the frames of other
+    // segments
+    std::vector<T> input((history + chunk_frames) * frame_len);
+    std::vector<T> output(chunk_frames * frame_len);
+
+    ThreadPool pool(jobs);
+
+    std::size_t first = 0;  // the index of the first frame in the chunk
+    sf_count_t read = 0;
+    while ((read = cover.readf(input.data() + history * frame_len,
+                               chunk_frames * frame_size)) > 0) {
+      // safe cast, read is > 0, only whole frames are embedded into
+      const std::size_t frames = (std::size_t)read / frame_size;
+      std::copy(input.begin() + history * frame_len,
+                input.begin() + history * frame_len + read * channels,
+                output.begin());
+
+      pool.run_all(jobs, [&](std::size_t w) {
+        const std::size_t from = frames * w / jobs;
+        const std::size_t to = frames * (w + 1) / jobs;
+        // the index of the first frame of one channel in the segment
+        const std::size_t start = (first + from) * channels;
+        if (start * frame_bits >= message.size() || from == to)
+          return;
+
+        const std::size_t warm = std::min(warmup, start);
+        streams[w]->seek((start - warm) * frame_bits);
+        // the embedder may have read ahead in the constructor
+        if (warmup > 0)
+          embedders[w] = make_embedder(*streams[w]);
+
+        Embedder<T>& embedder = *embedders[w];
+        for (std::size_t i = start - warm; i < start; i++) {
+          const T* frame =
+              input.data() + (history + i / channels - first) * frame_len;
+          demultiplex(frame, embedder.input().data(), frame_size,
+                      i % channels, channels);
+          (void)embedder.embed();
+        }
+
+        bool done = false;
+        for (std::size_t f = from; f < to && !done; f++) {
+          const T* in = input.data() + (history + f) * frame_len;
+          T* out = output.data() + f * frame_len;
+          for (int ch = 0; ch < channels && !done; ch++) {
+            demultiplex(in, embedder.input().data(), frame_size, ch, channels);
+            done = embedder.embed();
+            multiplex(embedder.output().data(), out, frame_size, ch,
+                      channels);
+          }
+        }
+      });
+      stego.writef(output.data(), read);
+
+      if (frames >= history) {
+        std::copy(input.begin() + frames * frame_len,
+                  input.begin() + (history + frames) * frame_len,
+                  input.begin());
+      }
+      first += frames;
     }
   }
 
  private:
+  /**
+   * @brief Open the stego file for writing with the parameters of this file.
+   */
+  SndfileHandle open_stego(const std::string& stegofile);
+
   SndfileHandle cover;
 };
 
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "dct.h"
+#include "planner.h"
+
+template <typename T>
+DCT<T>::DCT(unsigned N, aligned_vector<T>& in, aligned_vector<T>& out)
+    : N(N), plan(0), alignment(0), in(&in), out(&out)
+{
+}
+
+template <typename T>
+void DCT<T>::exec()
+{
+  T* x = in->data();
+  T* y = out->data();
+  const int align = plan_alignment<T>(x, y);
+  if (!plan || align != alignment) {
+    plan = shared_plan<T>(PlanKind::REDFT00, N, align);
+    alignment = align;
+  }
+  fftw_traits<T>::execute_r2r(plan, x, y);
+}
+
+template class DCT<double>;
+template class DCT<float>;
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DCT_H
+#define DCT_H
+
+#include <vector>
+
+#include "aligned_vector.h"
+#include "fftw_traits.h"
+
+/**
+ * @brief The type-I discrete cosine transform (DCT-I).
+ * @tparam T The precision of the samples, double or float.
+ *
+ * The DCT-I of N samples is equivalent to the DFT of their even extension of
+ * length 2 * (N - 1). This makes it usable as the inverse of real and even
+ * spectra, given just the first half of the spectrum.
+ */
+template <typename T>
+class DCT {
+ public:
+  /**
+   * @brief Constructor.
+   * @param N The length of the input and output.
+   * @param in The input buffer.
+   * @param out The output buffer.
+   */
+  DCT(unsigned N, aligned_vector<T>& in, aligned_vector<T>& out);
+
+  /**
+   * @brief Run the DCT-I algorithm.
+   *
+   * The algorithm takes input in the input buffer and writes the
+   * unnormalized transform to the output buffer.
+   */
+  void exec();
+
+ private:
+  unsigned N;
+  // the shared plan for the alignment of the buffers
+  typename fftw_traits<T>::plan plan;
+  int alignment;
+
+  aligned_vector<T>* in;
+  aligned_vector<T>* out;
+};
+
+#endif
@@ -19,15 +19,17 @@
 
 #include "dsp_utils.h"
 
-void amplitude(std::complex<double>* dft, double* amp, unsigned N)
+template <typename T>
+void amplitude(const std::complex<T>* dft, T* amp, unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
     amp[i] = std::abs(dft[i]);
   }
 }
 
-void amplitude(const std::vector<std::complex<double>>& dft,
-               std::vector<double>& amp,
+template <typename T>
+void amplitude(const aligned_vector<std::complex<T>>& dft,
+               aligned_vector<T>& amp,
                unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
@@ -35,15 +37,17 @@ void amplitude(const std::vector<std::complex<double>>& dft,
   }
 }
 
-void angle(std::complex<double>* dft, double* phase, unsigned N)
+template <typename T>
+void angle(const std::complex<T>* dft, T* phase, unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
     phase[i] = std::arg(dft[i]);
   }
 }
 
-void angle(const std::vector<std::complex<double>>& dft,
-           std::vector<double>& phase,
+template <typename T>
+void angle(const aligned_vector<std::complex<T>>& dft,
+           aligned_vector<T>& phase,
            unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
@@ -51,9 +55,10 @@ void angle(const std::vector<std::complex<double>>& dft,
   }
 }
 
-void polar_to_cartesian(std::complex<double>* dft,
-                        double* amps,
-                        double* phases,
+template <typename T>
+void polar_to_cartesian(std::complex<T>* dft,
+                        const T* amps,
+                        const T* phases,
                         unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
@@ -61,9 +66,10 @@ void polar_to_cartesian(std::complex<double>* dft,
   }
 }
 
-void polar_to_cartesian(std::vector<std::complex<double>>& dft,
-                        const std::vector<double>& amps,
-                        const std::vector<double>& phases,
+template <typename T>
+void polar_to_cartesian(aligned_vector<std::complex<T>>& dft,
+                        const aligned_vector<T>& amps,
+                        const aligned_vector<T>& phases,
                         unsigned N)
 {
   for (std::size_t i = 0; i < N; i++) {
@@ -89,13 +95,58 @@ unsigned freq_to_bin(double freq, double fs, unsigned N)
  * @param signal The signal
  * @return The average power of the signal
  */
-double avg_power(std::vector<double>& signal)
+template <typename T>
+T avg_power(const aligned_vector<T>& signal)
 {
-  double avg_pwr = 0;
-  for (std::size_t i = 0; i < signal.size(); i++) {
+  return avg_power(signal.data(), signal.size());
+}
+
+template <typename T>
+T avg_power(const T* signal, std::size_t N)
+{
+  T avg_pwr = 0;
+  for (std::size_t i = 0; i < N; i++) {
     // the signal is always real -> absolute value omitted
     avg_pwr += signal[i] * signal[i];
   }
-  avg_pwr /= signal.size();
+  avg_pwr /= N;
   return avg_pwr;
 }
+
+template void amplitude(const std::complex<double>*, double*, unsigned);
+template void amplitude(const aligned_vector<std::complex<double>>&,
+                        aligned_vector<double>&,
+                        unsigned);
+template void angle(const std::complex<double>*, double*, unsigned);
+template void angle(const aligned_vector<std::complex<double>>&,
+                    aligned_vector<double>&,
+                    unsigned);
+template void polar_to_cartesian(std::complex<double>*,
+                                 const double*,
+                                 const double*,
+                                 unsigned);
+template void polar_to_cartesian(aligned_vector<std::complex<double>>&,
+                                 const aligned_vector<double>&,
+                                 const aligned_vector<double>&,
+                                 unsigned);
+template double avg_power(const aligned_vector<double>&);
+template double avg_power(const double*, std::size_t);
+
+template void amplitude(const std::complex<float>*, float*, unsigned);
+template void amplitude(const aligned_vector<std::complex<float>>&,
+                        aligned_vector<float>&,
+                        unsigned);
+template void angle(const std::complex<float>*, float*, unsigned);
+template void angle(const aligned_vector<std::complex<float>>&,
+                    aligned_vector<float>&,
+                    unsigned);
+template void polar_to_cartesian(std::complex<float>*,
+                                 const float*,
+                                 const float*,
+                                 unsigned);
+template void polar_to_cartesian(aligned_vector<std::complex<float>>&,
+                                 const aligned_vector<float>&,
+                                 const aligned_vector<float>&,
+                                 unsigned);
+template float avg_power(const aligned_vector<float>&);
+template float avg_power(const float*, std::size_t);
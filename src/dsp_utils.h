@@ -25,8 +25,28 @@
 #include <cstddef>
 #include <vector>
 
+#include "aligned_vector.h"
+
 using namespace std;
 
+// the number of frames processed at once by the channel-parallel file
+// processing, see CoverFile::embed_channels()
+#define CHANNEL_BLOCK_FRAMES 32
+
+// the default number of frames processed at once by the serial file
+// processing, see CoverFile::embed()
+#define DEF_BLOCK_FRAMES 8
+
+// the number of frames in each block passed between the stages of the
+// pipelined file processing, see CoverFile::embed_pipelined()
+#define PIPELINE_BLOCK_FRAMES 8
+// the number of blocks in flight in the pipelined file processing
+#define PIPELINE_BLOCKS 8
+
+// the number of frames processed by each worker at once in the
+// segment-parallel file processing, see CoverFile::embed_segments()
+#define SEGMENT_BLOCK_FRAMES 16
+
 /**
  * Demultiplex (deinterleave) a channel from interleaved signal.
  * @param in The interleaved signal.
@@ -36,7 +56,7 @@ using namespace std;
  */
 template <typename T>
 void demultiplex(const std::vector<T>& in,
-                 std::vector<T>& chan,
+                 aligned_vector<T>& chan,
                  int chnum,
                  int channels)
 {
@@ -54,7 +74,7 @@ void demultiplex(const std::vector<T>& in,
  * @param chan The total number of channels in the input signal.
  */
 template <typename T>
-void multiplex(const std::vector<T>& chan,
+void multiplex(const aligned_vector<T>& chan,
                std::vector<T>& out,
                int chnum,
                int channels)
@@ -65,35 +85,81 @@ void multiplex(const std::vector<T>& chan,
   }
 }
 
+/**
+ * Demultiplex (deinterleave) a channel from a part of interleaved signal.
+ * @param in The interleaved signal.
+ * @param chan The buffer for the retrieved channel.
+ * @param frames The number of samples in each channel to retrieve.
+ * @param chnum The number of the channel to retrieve.
+ * @param channels The total number of channels in the input signal.
+ */
+template <typename T>
+void demultiplex(const T* in,
+                 T* chan,
+                 std::size_t frames,
+                 int chnum,
+                 int channels)
+{
+  for (std::size_t i = 0; i < frames; i++) {
+    chan[i] = in[i * channels + chnum];
+  }
+}
+
+/**
+ * Multiplex (interleave) channel into a part of signal.
+ * @param chan The channel to interleave.
+ * @param out The signal to interleave.
+ * @param frames The number of samples in the channel.
+ * @param chnum The number of the channel to interleave.
+ * @param channels The total number of channels in the output signal.
+ */
+template <typename T>
+void multiplex(const T* chan,
+               T* out,
+               std::size_t frames,
+               int chnum,
+               int channels)
+{
+  for (std::size_t i = 0; i < frames; i++) {
+    out[i * channels + chnum] = chan[i];
+  }
+}
+
 /**
  * Get amplitude from DFT
  */
-void amplitude(const std::complex<double>* dft, double* amp, unsigned N);
+template <typename T>
+void amplitude(const std::complex<T>* dft, T* amp, unsigned N);
 
-void amplitude(const std::vector<std::complex<double>>& dft,
-               std::vector<double>& amp,
+template <typename T>
+void amplitude(const aligned_vector<std::complex<T>>& dft,
+               aligned_vector<T>& amp,
                unsigned N);
 
 /**
  * Get phase from DFT
  */
-void angle(std::complex<double>* dft, double* phase, unsigned N);
+template <typename T>
+void angle(const std::complex<T>* dft, T* phase, unsigned N);
 
-void angle(const std::vector<std::complex<double>>& dft,
-           std::vector<double>& phase,
+template <typename T>
+void angle(const aligned_vector<std::complex<T>>& dft,
+           aligned_vector<T>& phase,
            unsigned N);
 
 /**
  * Recreate DFT from amplitude and phase
  */
-void polar_to_cartesian(std::complex<double>* dft,
-                        const double* amps,
-                        const double* phases,
+template <typename T>
+void polar_to_cartesian(std::complex<T>* dft,
+                        const T* amps,
+                        const T* phases,
                         unsigned N);
 
-void polar_to_cartesian(std::vector<std::complex<double>>& dft,
-                        const std::vector<double>& amps,
-                        const std::vector<double>& phases,
+template <typename T>
+void polar_to_cartesian(aligned_vector<std::complex<T>>& dft,
+                        const aligned_vector<T>& amps,
+                        const aligned_vector<T>& phases,
                         unsigned N);
 
 /**
@@ -111,6 +177,10 @@ unsigned freq_to_bin(double freq, double fs, unsigned N);
  * @param signal The signal
  * @return The average power of the signal
  */
-double avg_power(std::vector<double>& signal);
+template <typename T>
+T avg_power(const aligned_vector<T>& signal);
+
+template <typename T>
+T avg_power(const T* signal, std::size_t N);
 
 #endif
@@ -43,17 +43,26 @@ EchoHidingMethod::EchoHidingMethod(const Params& params)
   amp = params.get_or("amp", 0.4);
   if (amp <= 0)
     throw std::invalid_argument("amp must be positive");
+
+  single = single_precision(params);
 }
 
 embedder_variant EchoHidingMethod::make_embedder(InBitStream& input) const
 {
-  return std::make_unique<EchoHidingEmbedder>(input, frame_size, amp, delay0,
-                                              delay1);
+  if (single)
+    return std::make_unique<EchoHidingEmbedder<float>>(input, frame_size, amp,
+                                                       delay0, delay1);
+  return std::make_unique<EchoHidingEmbedder<double>>(input, frame_size, amp,
+                                                      delay0, delay1);
 }
 
 extractor_variant EchoHidingMethod::make_extractor() const
 {
-  return std::make_unique<EchoHidingExtractor>(frame_size, delay0, delay1);
+  if (single)
+    return std::make_unique<EchoHidingExtractor<float>>(frame_size, delay0,
+                                                        delay1);
+  return std::make_unique<EchoHidingExtractor<double>>(frame_size, delay0,
+                                                       delay1);
 }
 
 ssize_t EchoHidingMethod::capacity(std::size_t samples) const
@@ -61,24 +70,53 @@ ssize_t EchoHidingMethod::capacity(std::size_t samples) const
   return std::round(samples / (double)frame_size);
 }
 
+ssize_t EchoHidingMethod::frame_bits() const
+{
+  return 1;
+}
 
-EchoHidingEmbedder::EchoHidingEmbedder(InBitStream& data,
-                                       std::size_t frame_size,
-                                       double echo_amp,
-                                       unsigned echo_delay_zero,
-                                       unsigned echo_delay_one)
-    : Embedder<double>::Embedder(data, frame_size),
+std::size_t EchoHidingMethod::embed_warmup() const
+{
+  // the delays are at most one frame long, so one frame fills the
+  // convolution history, it also sets the mixer from the current bit
+  return 1;
+}
+
+bool EchoHidingMethod::independent_extraction() const
+{
+  return true;
+}
+
+
+/**
+ * @brief Create an echo kernel with a single tap.
+ * @param delay The echo delay in samples.
+ * @param amp The echo amplitude.
+ */
+template <typename T>
+static aligned_vector<T> make_kernel(unsigned delay, double amp)
+{
+  aligned_vector<T> kernel(delay, 0);
+  kernel[delay - 1] = amp;
+  return kernel;
+}
+
+template <typename T>
+EchoHidingEmbedder<T>::EchoHidingEmbedder(InBitStream& data,
+                                          std::size_t frame_size,
+                                          double echo_amp,
+                                          unsigned echo_delay_zero,
+                                          unsigned echo_delay_one)
+    : Embedder<T>::Embedder(data, frame_size),
       next_bit(data.next_bit()),
-      kernel_zero(echo_delay_zero, 0),
-      kernel_one(echo_delay_one, 0),
-      echo_zero(pow(2,next_pow2(in_frame.size() + echo_delay_zero - 1)), 0),
-      echo_one(pow(2,next_pow2(in_frame.size() +  echo_delay_one - 1)), 0),
-      mixer(2 * in_frame.size(), next_bit),
-      conv_zero(in_frame, kernel_zero, echo_zero),
-      conv_one(in_frame, kernel_one, echo_one)
+      kernel_zero(make_kernel<T>(echo_delay_zero, echo_amp)),
+      kernel_one(make_kernel<T>(echo_delay_one, echo_amp)),
+      echo_zero(this->in_frame.size(), 0),
+      echo_one(this->in_frame.size(), 0),
+      mixer(2 * this->in_frame.size(), next_bit),
+      conv_zero(this->in_frame, kernel_zero, echo_zero),
+      conv_one(this->in_frame, kernel_one, echo_one)
 {
-  kernel_zero[echo_delay_zero - 1] = echo_amp;
-  kernel_one[echo_delay_one - 1] = echo_amp;
 }
 
 template <class ForwardIt>
@@ -92,9 +130,10 @@ void linspace(ForwardIt first, ForwardIt last, double from, double to)
   }
 }
 
-void EchoHidingEmbedder::update_mixer(char bit_from, char bit_to)
+template <typename T>
+void EchoHidingEmbedder<T>::update_mixer(char bit_from, char bit_to)
 {
-  const int start = SMOOTHING_PCT * in_frame.size();
+  const int start = SMOOTHING_PCT * this->in_frame.size();
   const int end = mixer.size() - start;
 
   if (bit_from == bit_to) {
@@ -109,13 +148,16 @@ void EchoHidingEmbedder::update_mixer(char bit_from, char bit_to)
   std::fill(mixer.begin() + end, mixer.end(), bit_to);
 }
 
-bool EchoHidingEmbedder::embed()
+template <typename T>
+bool EchoHidingEmbedder<T>::embed()
 {
   int bit = next_bit;
   if (bit == EOF) {
+    std::copy(this->in_frame.begin(), this->in_frame.end(),
+              this->out_frame.begin());
     return true;
   }
-  next_bit = data.next_bit();
+  next_bit = this->data.next_bit();
 
   // create echo
   conv_one.exec();
@@ -126,40 +168,74 @@ bool EchoHidingEmbedder::embed()
     update_mixer(bit, next_bit == EOF ? 0 : next_bit);
 
     // add the echo to the signal
-    for (std::size_t i = 0; i < in_frame.size(); i++) {
-      out_frame[i] = in_frame[i] + echo_one[i] * mixer[i] + echo_zero[i] * (1 - mixer[i]);
+    for (std::size_t i = 0; i < this->in_frame.size(); i++) {
+      this->out_frame[i] = this->in_frame[i] + echo_one[i] * mixer[i] +
+                           echo_zero[i] * (1 - mixer[i]);
     }
     // shift the mixer
     std::move(mixer.begin() + (mixer.size() / 2), mixer.end(), mixer.begin());
   } else {
-    for (std::size_t i = 0; i < in_frame.size(); i++) {
-      double echo = bit ? echo_one[i] : echo_zero[i];
-      out_frame[i] = in_frame[i] + echo;
+    for (std::size_t i = 0; i < this->in_frame.size(); i++) {
+      T echo = bit ? echo_one[i] : echo_zero[i];
+      this->out_frame[i] = this->in_frame[i] + echo;
     }
   }
 
   return next_bit == EOF;
 }
 
-EchoHidingExtractor::EchoHidingExtractor(std::size_t frame_size,
-                                         unsigned echo_delay_zero,
-                                         unsigned echo_delay_one)
-    : Extractor<double>(frame_size),
+template <typename T>
+EchoHidingExtractor<T>::EchoHidingExtractor(std::size_t frame_size,
+                                            unsigned echo_delay_zero,
+                                            unsigned echo_delay_one)
+    : Extractor<T>(frame_size),
       echo_delay_zero(echo_delay_zero),
       echo_delay_one(echo_delay_one),
-      autocorrelation(pow(2, next_pow2(2 * in_frame.size() - 1))),
-      autocorrelate(in_frame, autocorrelation)
+      autocorrelation(pow(2, next_pow2(2 * this->in_frame.size() - 1))),
+      autocorrelate(this->in_frame, autocorrelation),
+      batch(frame_size,
+            autocorrelate.transform_size(),
+            autocorrelate.transform_size() / 2 + 1,
+            false)
 {
+  autocorrelate.select_lags({echo_delay_zero - 1, echo_delay_one - 1});
 }
 
-bool EchoHidingExtractor::extract(OutBitStream& data)
+template <typename T>
+bool EchoHidingExtractor<T>::extract(OutBitStream& data)
 {
   autocorrelate.exec();
+  decode(data);
+  return true;
+}
+
+template <typename T>
+bool EchoHidingExtractor<T>::extract_frames(const PlanarBlock<const T>& block,
+                                            OutBitStream& data)
+{
+  const unsigned count = block.count();
+
+  batch.forward(block.data(), count);
+  for (unsigned i = 0; i < count; i++) {
+    if (data.eof())
+      return false;
+    autocorrelate.analyze(batch.spectrum(i));
+    decode(data);
+  }
+  return true;
+}
 
-  double c0 = autocorrelation[echo_delay_zero - 1];
-  double c1 = autocorrelation[echo_delay_one - 1];
+template <typename T>
+void EchoHidingExtractor<T>::decode(OutBitStream& data)
+{
+  T c0 = autocorrelation[echo_delay_zero - 1];
+  T c1 = autocorrelation[echo_delay_one - 1];
 
   char bit = c0 < c1;
   data.output_bit(bit);
-  return true;
 }
+
+template class EchoHidingEmbedder<double>;
+template class EchoHidingEmbedder<float>;
+template class EchoHidingExtractor<double>;
+template class EchoHidingExtractor<float>;
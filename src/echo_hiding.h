@@ -22,6 +22,7 @@
 #define ECHO_HIDING_H
 
 #include "autocepstrum.h"
+#include "channel_batch.h"
 #include "conv.h"
 #include "embedder.h"
 #include "extractor.h"
@@ -35,15 +36,20 @@ class EchoHidingMethod : public Method {
   embedder_variant make_embedder(InBitStream& input) const override;
   extractor_variant make_extractor() const override;
   virtual ssize_t capacity(std::size_t samples) const override;
+  virtual ssize_t frame_bits() const override;
+  virtual std::size_t embed_warmup() const override;
+  virtual bool independent_extraction() const override;
 
  protected:
   std::size_t frame_size;
   unsigned delay0;
   unsigned delay1;
   double amp;
+  bool single;
 };
 
-class EchoHidingEmbedder : public Embedder<double> {
+template <typename T>
+class EchoHidingEmbedder : public Embedder<T> {
  public:
   EchoHidingEmbedder(InBitStream& data,
                      std::size_t frame_size,
@@ -58,30 +64,37 @@ class EchoHidingEmbedder : public Embedder<double> {
 
   int next_bit;
 
-  std::vector<double> kernel_zero;
-  std::vector<double> kernel_one;
-  std::vector<double> echo_zero;
-  std::vector<double> echo_one;
-  std::vector<double> mixer;
+  aligned_vector<T> kernel_zero;
+  aligned_vector<T> kernel_one;
+  aligned_vector<T> echo_zero;
+  aligned_vector<T> echo_one;
+  aligned_vector<T> mixer;
 
-  Conv conv_zero;
-  Conv conv_one;
+  SparseConv<T> conv_zero;
+  SparseConv<T> conv_one;
 };
 
-class EchoHidingExtractor : public Extractor<double> {
+template <typename T>
+class EchoHidingExtractor : public Extractor<T> {
  public:
   EchoHidingExtractor(std::size_t frame_size,
                       unsigned echo_delay_zero,
                       unsigned echo_delay_one);
 
   bool extract(OutBitStream& data) override;
+  bool extract_frames(const PlanarBlock<const T>& block,
+                      OutBitStream& data) override;
 
  private:
+  void decode(OutBitStream& data);
+
   unsigned echo_delay_zero;
   unsigned echo_delay_one;
 
-  std::vector<double> autocorrelation;
-  Autocepstrum autocorrelate;
+  aligned_vector<T> autocorrelation;
+  Autocepstrum<T> autocorrelate;
+
+  ChannelBatch<T> batch;
 };
 
 #endif
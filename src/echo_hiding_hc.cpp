@@ -32,6 +32,11 @@
 // the percentage of the the frame to use for transition
 #define SMOOTHING_PCT 0.25
 
+// the indices of the echoes in the convolution
+#define ECHO_CURR 0
+#define ECHO_PREV 1
+#define ECHO_NEXT 2
+
 EchoHidingHCMethod::EchoHidingHCMethod(const Params& params)
 {
   frame_size = params.get_or("framesize", 4096);
@@ -48,17 +53,26 @@ EchoHidingHCMethod::EchoHidingHCMethod(const Params& params)
         "echo interval must be smaller than " +
         std::to_string((unsigned)std::floor(frame_size / 10)));
   }
+
+  single = single_precision(params);
 }
 
 embedder_variant EchoHidingHCMethod::make_embedder(InBitStream& input) const
 {
-  return make_unique<EchoHidingHCEmbedder>(input, frame_size, echo_interval,
-                                           amp);
+  if (single)
+    return make_unique<EchoHidingHCEmbedder<float>>(input, frame_size,
+                                                    echo_interval, amp);
+  return make_unique<EchoHidingHCEmbedder<double>>(input, frame_size,
+                                                   echo_interval, amp);
 }
 
 extractor_variant EchoHidingHCMethod::make_extractor() const
 {
-  return make_unique<EchoHidingHCExtractor>(frame_size, echo_interval);
+  if (single)
+    return make_unique<EchoHidingHCExtractor<float>>(frame_size,
+                                                     echo_interval);
+  return make_unique<EchoHidingHCExtractor<double>>(frame_size,
+                                                    echo_interval);
 }
 
 ssize_t EchoHidingHCMethod::capacity(std::size_t samples) const
@@ -66,6 +80,11 @@ ssize_t EchoHidingHCMethod::capacity(std::size_t samples) const
   return std::round(samples / (double)frame_size) * 4;
 }
 
+bool EchoHidingHCMethod::independent_extraction() const
+{
+  return true;
+}
+
 static bool get_bits(std::array<int, N_ECHOS>& bits, InBitStream& data)
 {
   for (unsigned i = 0; i < bits.size(); i++) {
@@ -84,9 +103,10 @@ static int distance_multiplier(bool bit_a, bool bit_b)
   return x + 1;
 }
 
-void EchoHidingHCEmbedder::make_kernel(std::vector<double>& kernel,
-                                       const std::array<int, N_ECHOS>& bits,
-                                       double amp)
+template <typename T>
+void EchoHidingHCEmbedder<T>::make_kernel(aligned_vector<T>& kernel,
+                                          const std::array<int, N_ECHOS>& bits,
+                                          double amp)
 {
   // create echo
   int delay = echo_interval * distance_multiplier(bits[0], bits[1]);
@@ -98,42 +118,78 @@ void EchoHidingHCEmbedder::make_kernel(std::vector<double>& kernel,
   kernel[delay - 1] = -amp;
 }
 
-EchoHidingHCEmbedder::EchoHidingHCEmbedder(InBitStream& data,
-                                           std::size_t frame_size,
-                                           std::size_t kernel_len,
-                                           double echo_amp)
-    : Embedder<double>::Embedder(data, frame_size),
+static unsigned to_symbol(const std::array<int, N_ECHOS>& bits)
+{
+  unsigned symbol = 0;
+  for (unsigned i = 0; i < bits.size(); i++) {
+    symbol = (symbol << 1) | bits[i];
+  }
+  return symbol;
+}
+
+template <typename T>
+EchoHidingHCEmbedder<T>::EchoHidingHCEmbedder(InBitStream& data,
+                                              std::size_t frame_size,
+                                              std::size_t kernel_len,
+                                              double echo_amp)
+    : Embedder<T>::Embedder(data, frame_size),
       amp(echo_amp),
       echo_interval(kernel_len / 9 * 2),
-      kernel(kernel_len, 0),
-      echo(pow(2, next_pow2(in_frame.size() + kernel_len - 1)), 0),
-      next_kernel(kernel_len, 0),
-      next_echo(pow(2, next_pow2(in_frame.size() + kernel_len - 1)), 0),
-      prev_kernel(kernel_len, 0),
-      prev_echo(pow(2, next_pow2(in_frame.size() + kernel_len - 1)), 0),
+      spectra(N_SYMBOLS + 1),
+      symbol(0),
+      next_symbol(0),
+      prev_symbol(N_SYMBOLS),
       mixer(frame_size, 0),
-      conv(in_frame, kernel, echo),
-      prev_conv(in_frame, prev_kernel, prev_echo),
-      next_conv(in_frame, next_kernel, next_echo)
+      conv(this->in_frame, kernel_len, USE_SMOOTHING ? 3 : 1),
+      batch(frame_size,
+            conv.transform_size(),
+            conv.transform_size() / 2 + 1,
+            false)
 {
+  make_spectra(kernel_len);
 }
 
-EchoHidingHCEmbedder::EchoHidingHCEmbedder(InBitStream& data,
-                                           std::size_t frame_size,
-                                           unsigned echo_interval,
-                                           double echo_amp)
+template <typename T>
+EchoHidingHCEmbedder<T>::EchoHidingHCEmbedder(InBitStream& data,
+                                              std::size_t frame_size,
+                                              unsigned echo_interval,
+                                              double echo_amp)
     : EchoHidingHCEmbedder(data,
                            frame_size,
                            (std::size_t)echo_interval * 9 / 2,
                            echo_amp)
 {
   make_mixer();
-  // use some "random" echo as the previous
-  prev_kernel[2 * echo_interval] = amp;
-  prev_kernel[echo_interval / 2 + 3 * echo_interval] = -amp;
 
   get_bits(bits, data);
-  make_kernel(kernel, bits, amp);
+  symbol = to_symbol(bits);
+}
+
+/**
+ * Transforms the kernels of all symbols. There are only N_SYMBOLS distinct
+ * kernels, so they don't have to be transformed in every frame.
+ */
+template <typename T>
+void EchoHidingHCEmbedder<T>::make_spectra(std::size_t kernel_len)
+{
+  aligned_vector<T> kernel(kernel_len, 0);
+
+  for (unsigned s = 0; s < N_SYMBOLS; s++) {
+    std::array<int, N_ECHOS> symbol_bits;
+    for (unsigned i = 0; i < symbol_bits.size(); i++) {
+      symbol_bits[i] = s >> (symbol_bits.size() - 1 - i) & 0x1;
+    }
+
+    std::fill(kernel.begin(), kernel.end(), 0);
+    make_kernel(kernel, symbol_bits, amp);
+    conv.transform(kernel, spectra[s]);
+  }
+
+  // use some "random" echo as the previous
+  std::fill(kernel.begin(), kernel.end(), 0);
+  kernel[2 * echo_interval] = amp;
+  kernel[echo_interval / 2 + 3 * echo_interval] = -amp;
+  conv.transform(kernel, spectra[N_SYMBOLS]);
 }
 
 template <class ForwardIt>
@@ -147,9 +203,10 @@ static void sin_slope(ForwardIt first, ForwardIt last, double from, double to)
   }
 }
 
-void EchoHidingHCEmbedder::make_mixer()
+template <typename T>
+void EchoHidingHCEmbedder<T>::make_mixer()
 {
-  const int start = SMOOTHING_PCT * in_frame.size();
+  const int start = SMOOTHING_PCT * this->in_frame.size();
   const int end = mixer.size() - start;
 
   std::fill(mixer.begin() + start, mixer.begin() + end, 1);
@@ -162,57 +219,134 @@ void EchoHidingHCEmbedder::make_mixer()
   sin_slope(mixer.begin() + end, mixer.end(), sin_half, sin_end);
 }
 
-bool EchoHidingHCEmbedder::embed()
+template <typename T>
+bool EchoHidingHCEmbedder<T>::embed()
+{
+  return embed_frame(this->in_frame.data(), nullptr);
+}
+
+template <typename T>
+bool EchoHidingHCEmbedder<T>::embed_frames(const PlanarBlock<T>& block)
 {
-  if (!get_bits(bits, data))
+  const unsigned count = block.count();
+  aligned_vector<T>& out_frame = this->out_frame;
+
+  batch.forward(block.data(), count);
+  for (unsigned i = 0; i < count; i++) {
+    T* frame = block.frame(i);
+    const bool done = embed_frame(frame, batch.spectrum(i));
+    std::copy(out_frame.begin(), out_frame.end(), frame);
+    if (done)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Embeds into the given frame, writing to the output frame. The spectrum of
+ * the zero-padded frame is computed by the convolution, unless given.
+ */
+template <typename T>
+bool EchoHidingHCEmbedder<T>::embed_frame(const T* in,
+                                          const std::complex<T>* spectrum)
+{
+  if (!get_bits(bits, this->data))
     return true;
 
+  const std::size_t frame_size = this->_frame_size;
+  aligned_vector<T>& out_frame = this->out_frame;
+
   if (USE_SMOOTHING) {
-    std::fill(next_kernel.begin(), next_kernel.end(), 0);
-    make_kernel(next_kernel, bits, amp);
+    next_symbol = to_symbol(bits);
+
+    conv.set_spectrum(ECHO_PREV, spectra[prev_symbol]);
+    conv.set_spectrum(ECHO_CURR, spectra[symbol]);
+    conv.set_spectrum(ECHO_NEXT, spectra[next_symbol]);
+    if (spectrum)
+      conv.convolve(spectrum);
+    else
+      conv.exec();
 
-    prev_conv.exec();
-    conv.exec();
-    next_conv.exec();
+    const T* prev_echo = conv.output(ECHO_PREV);
+    const T* echo = conv.output(ECHO_CURR);
+    const T* next_echo = conv.output(ECHO_NEXT);
 
-    for (std::size_t i = 0; i < in_frame.size() / 2; i++) {
-      out_frame[i] =
-          in_frame[i] + echo[i] * mixer[i] + prev_echo[i] * (1 - mixer[i]);
+    for (std::size_t i = 0; i < frame_size / 2; i++) {
+      out_frame[i] = in[i] + echo[i] * mixer[i] + prev_echo[i] * (1 - mixer[i]);
     }
-    for (std::size_t i = in_frame.size() / 2; i < in_frame.size(); i++) {
-      out_frame[i] =
-          in_frame[i] + echo[i] * mixer[i] + next_echo[i] * (1 - mixer[i]);
+    for (std::size_t i = frame_size / 2; i < frame_size; i++) {
+      out_frame[i] = in[i] + echo[i] * mixer[i] + next_echo[i] * (1 - mixer[i]);
     }
 
-    prev_kernel = kernel;
-    kernel = next_kernel;
+    prev_symbol = symbol;
+    symbol = next_symbol;
   } else {
-    std::fill(kernel.begin(), kernel.end(), 0);
-    make_kernel(kernel, bits, amp);
-    conv.exec();
-    for (std::size_t i = 0; i < in_frame.size(); i++) {
-      out_frame[i] = in_frame[i] + echo[i];
+    symbol = to_symbol(bits);
+    conv.set_spectrum(ECHO_CURR, spectra[symbol]);
+    if (spectrum)
+      conv.convolve(spectrum);
+    else
+      conv.exec();
+
+    const T* echo = conv.output(ECHO_CURR);
+    for (std::size_t i = 0; i < frame_size; i++) {
+      out_frame[i] = in[i] + echo[i];
     }
   }
   return false;
 }
 
-EchoHidingHCExtractor::EchoHidingHCExtractor(std::size_t frame_size,
-                                             unsigned echo_interval)
-    : Extractor<double>(frame_size),
+template <typename T>
+EchoHidingHCExtractor<T>::EchoHidingHCExtractor(std::size_t frame_size,
+                                                unsigned echo_interval)
+    : Extractor<T>(frame_size),
       echo_interval(echo_interval),
       // next power of two for faster FFT
-      autocorrelation(pow(2, next_pow2(2 * in_frame.size() - 1))),
-      autocorrelate(in_frame, autocorrelation)
+      autocorrelation(pow(2, next_pow2(2 * this->in_frame.size() - 1))),
+      autocorrelate(this->in_frame, autocorrelation),
+      batch(frame_size,
+            autocorrelate.transform_size(),
+            autocorrelate.transform_size() / 2 + 1,
+            false)
 {
+  // only the coefficients at the echo delays are needed
+  std::vector<std::size_t> lags;
+  for (int i = 1; i <= N_ECHOS; i++) {
+    lags.push_back(i * echo_interval - 1);
+    lags.push_back(echo_interval / 2 + i * echo_interval - 1);
+  }
+  autocorrelate.select_lags(lags);
 }
 
-bool EchoHidingHCExtractor::extract(OutBitStream& data)
+template <typename T>
+bool EchoHidingHCExtractor<T>::extract(OutBitStream& data)
 {
   autocorrelate.exec();
+  decode(data);
+  return true;
+}
+
+template <typename T>
+bool EchoHidingHCExtractor<T>::extract_frames(const PlanarBlock<const T>& block,
+                                              OutBitStream& data)
+{
+  const unsigned count = block.count();
 
+  batch.forward(block.data(), count);
+  for (unsigned i = 0; i < count; i++) {
+    if (data.eof())
+      return false;
+    autocorrelate.analyze(batch.spectrum(i));
+    decode(data);
+  }
+  return true;
+}
+
+template <typename T>
+void EchoHidingHCExtractor<T>::decode(OutBitStream& data)
+{
   // extract the first 2 bits from positive echo delay
-  double pos_coefs[N_ECHOS];
+  T pos_coefs[N_ECHOS];
   for (int i = 1; i <= N_ECHOS; i++) {
     pos_coefs[i - 1] = autocorrelation[i * echo_interval - 1];
   }
@@ -222,7 +356,7 @@ bool EchoHidingHCExtractor::extract(OutBitStream& data)
   data.output_bit(max_coef & 0x1);
 
   // extract the other 2 bits from negative echo delay
-  double neg_coefs[N_ECHOS];
+  T neg_coefs[N_ECHOS];
   for (int i = 1; i <= N_ECHOS; i++) {
     neg_coefs[i - 1] =
         autocorrelation[echo_interval / 2 + i * echo_interval - 1];
@@ -231,6 +365,9 @@ bool EchoHidingHCExtractor::extract(OutBitStream& data)
       distance(neg_coefs, min_element(neg_coefs, neg_coefs + N_ECHOS));
   data.output_bit(min_coef >> 1 & 0x1);
   data.output_bit(min_coef & 0x1);
-
-  return true;
 }
+
+template class EchoHidingHCEmbedder<double>;
+template class EchoHidingHCEmbedder<float>;
+template class EchoHidingHCExtractor<double>;
+template class EchoHidingHCExtractor<float>;
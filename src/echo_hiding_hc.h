@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "autocepstrum.h"
+#include "channel_batch.h"
 #include "conv.h"
 #include "embedder.h"
 #include "extractor.h"
@@ -33,6 +34,8 @@
 #include "methods.h"
 
 #define N_ECHOS 4
+// the number of distinct kernels, one for each combination of bits
+#define N_SYMBOLS (1 << N_ECHOS)
 
 class EchoHidingHCMethod : public Method {
  public:
@@ -40,14 +43,17 @@ class EchoHidingHCMethod : public Method {
   embedder_variant make_embedder(InBitStream& input) const override;
   extractor_variant make_extractor() const override;
   virtual ssize_t capacity(std::size_t samples) const override;
+  virtual bool independent_extraction() const override;
 
  protected:
   std::size_t frame_size;
   unsigned echo_interval;
   double amp;
+  bool single;
 };
 
-class EchoHidingHCEmbedder : public Embedder<double> {
+template <typename T>
+class EchoHidingHCEmbedder : public Embedder<T> {
  public:
   EchoHidingHCEmbedder(InBitStream& data,
                        std::size_t frame_size,
@@ -55,6 +61,7 @@ class EchoHidingHCEmbedder : public Embedder<double> {
                        double echo_amp);
 
   bool embed() override;
+  bool embed_frames(const PlanarBlock<T>& block) override;
 
  private:
   EchoHidingHCEmbedder(InBitStream& data,
@@ -63,41 +70,49 @@ class EchoHidingHCEmbedder : public Embedder<double> {
                        double echo_amp);
 
   void make_mixer();
-  void make_kernel(std::vector<double>& kernel,
+  void make_kernel(aligned_vector<T>& kernel,
                    const std::array<int, N_ECHOS>& bits,
                    double amp);
+  void make_spectra(std::size_t kernel_len);
+  bool embed_frame(const T* in, const std::complex<T>* spectrum);
 
   double amp;
   std::size_t echo_interval;
 
   std::array<int, N_ECHOS> bits;
 
-  std::vector<double> kernel;
-  std::vector<double> echo;
+  // the kernel spectra for all symbols and the initial previous kernel
+  std::vector<aligned_vector<std::complex<T>>> spectra;
 
-  std::vector<double> next_kernel;
-  std::vector<double> next_echo;
-  std::vector<double> prev_kernel;
-  std::vector<double> prev_echo;
+  unsigned symbol;
+  unsigned next_symbol;
+  unsigned prev_symbol;
 
-  std::vector<double> mixer;
+  aligned_vector<T> mixer;
 
-  Conv conv;
-  Conv prev_conv;
-  Conv next_conv;
+  MultiConv<T> conv;
+
+  ChannelBatch<T> batch;
 };
 
-class EchoHidingHCExtractor : public Extractor<double> {
+template <typename T>
+class EchoHidingHCExtractor : public Extractor<T> {
  public:
   EchoHidingHCExtractor(std::size_t frame_size, unsigned echo_interval);
 
   bool extract(OutBitStream& data) override;
+  bool extract_frames(const PlanarBlock<const T>& block,
+                      OutBitStream& data) override;
 
  private:
+  void decode(OutBitStream& data);
+
   unsigned echo_interval;
 
-  std::vector<double> autocorrelation;
-  Autocepstrum autocorrelate;
+  aligned_vector<T> autocorrelation;
+  Autocepstrum<T> autocorrelate;
+
+  ChannelBatch<T> batch;
 };
 
 #endif
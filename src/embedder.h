@@ -17,10 +17,13 @@
 #ifndef EMBEDDER_H
 #define EMBEDDER_H
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 
+#include "aligned_vector.h"
 #include "ibitstream.h"
+#include "planar_block.h"
 
 #define DEF_FRAME_SIZE 4096
 
@@ -34,6 +37,11 @@
 template <typename T>
 class Embedder {
  public:
+  /**
+   * @brief The data type of samples.
+   */
+  using sample_type = T;
+
   /**
    * @brief Constructor.
    *
@@ -70,17 +78,41 @@ class Embedder {
    */
   [[nodiscard]] virtual bool embed() = 0;
 
+  /**
+   * @brief Embed data into a block of consecutive frames of every channel.
+   *
+   * The frames of single channels are embedded into one after another in the
+   * order of the block, the same as calling embed() for each of them. The
+   * frames after the one in which the embedding is done are left untouched.
+   * Methods may override this to process the whole block at once, e.g. with
+   * batched transforms, or in place without copying the frames.
+   * @param block The block, embedded in place.
+   * @return Whether the embedding is done
+   */
+  [[nodiscard]] virtual bool embed_frames(const PlanarBlock<T>& block)
+  {
+    for (std::size_t i = 0; i < block.count(); i++) {
+      T* frame = block.frame(i);
+      std::copy(frame, frame + _frame_size, in_frame.begin());
+      const bool done = embed();
+      std::copy(out_frame.begin(), out_frame.end(), frame);
+      if (done)
+        return true;
+    }
+    return false;
+  }
+
   /**
    * @brief Get input frame.
    * @return Reference to the input frame.
    */
-  const std::vector<T>& input() const { return in_frame; }
+  const aligned_vector<T>& input() const { return in_frame; }
 
   /**
    * @brief Get output frame.
    * @return Reference to the output frame.
    */
-  const std::vector<T>& output() const { return out_frame; }
+  const aligned_vector<T>& output() const { return out_frame; }
 
   /**
    * @brief Get non-const reference to the input frame.
@@ -88,7 +120,7 @@ class Embedder {
    * This is used to write into the input frame.
    * @return Reference to the output frame.
    */
-  std::vector<T>& input() { return in_frame; }
+  aligned_vector<T>& input() { return in_frame; }
 
   /**
    * @brief Get the size of input and output frames.
@@ -98,8 +130,8 @@ class Embedder {
 
  protected:
   std::size_t _frame_size;
-  std::vector<T> in_frame;
-  std::vector<T> out_frame;
+  aligned_vector<T> in_frame;
+  aligned_vector<T> out_frame;
   InBitStream& data;
 };
 
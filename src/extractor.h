@@ -17,10 +17,13 @@
 #ifndef EXTRACTOR_H
 #define EXTRACTOR_H
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 
+#include "aligned_vector.h"
 #include "obitstream.h"
+#include "planar_block.h"
 
 #define DEF_FRAME_SIZE 4096
 
@@ -34,6 +37,11 @@
 template <typename T>
 class Extractor {
  public:
+  /**
+   * @brief The data type of samples.
+   */
+  using sample_type = T;
+
   /**
    * @brief Constructor.
    *
@@ -59,11 +67,41 @@ class Extractor {
    */
   virtual bool extract(OutBitStream& output) = 0;
 
+  /**
+   * @brief Extract data from a block of consecutive frames of every channel.
+   *
+   * The frames of single channels are extracted from one after another in the
+   * order of the block, the same as calling extract() for each of them, until
+   * the output bit stream is full. The extraction stops after the frame of
+   * all channels in which extract() returned false. Methods may override this
+   * to process the whole block at once, e.g. with batched transforms.
+   * @param block The block.
+   * @param output The output bit stream to write extracted data to
+   * @return true If should continue else false
+   */
+  virtual bool extract_frames(const PlanarBlock<const T>& block,
+                              OutBitStream& output)
+  {
+    for (std::size_t f = 0; f < block.frames(); f++) {
+      bool should_continue = true;
+      for (unsigned ch = 0; ch < block.channels(); ch++) {
+        if (output.eof())
+          return false;
+        const T* frame = block.frame(f, ch);
+        std::copy(frame, frame + _frame_size, in_frame.begin());
+        should_continue &= extract(output);
+      }
+      if (!should_continue)
+        return false;
+    }
+    return true;
+  }
+
   /**
    * @brief Get input frame.
    * @return Reference to the input frame.
    */
-  const std::vector<T>& input() const { return in_frame; }
+  const aligned_vector<T>& input() const { return in_frame; }
 
   /**
    * @brief Get non-const reference to the input frame.
@@ -71,7 +109,7 @@ class Extractor {
    * This is used to write into the input frame.
    * @return Reference to the output frame.
    */
-  std::vector<T>& input() { return in_frame; }
+  aligned_vector<T>& input() { return in_frame; }
 
   /**
    * @brief Get the size of input and output frames.
@@ -81,7 +119,7 @@ class Extractor {
 
  protected:
   std::size_t _frame_size;
-  std::vector<T> in_frame;
+  aligned_vector<T> in_frame;
 };
 
 #endif
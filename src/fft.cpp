@@ -15,27 +15,36 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "fft.h"
+#include "planner.h"
 
-FFT::FFT(unsigned N,
-         std::vector<double>& in,
-         std::vector<std::complex<double>>& out)
-    : N(N), plan(0), in(&in), out(&out)
+template <typename T>
+FFT<T>::FFT(unsigned N,
+            aligned_vector<T>& in,
+            aligned_vector<std::complex<T>>& out,
+            unsigned howmany)
+    : N(N),
+      plan(0),
+      alignment(0),
+      howmany(howmany),
+      idist(in.size() / howmany),
+      odist(out.size() / howmany),
+      in(&in),
+      out(&out)
 {
 }
 
-void FFT::exec()
+template <typename T>
+void FFT<T>::exec()
 {
-  if (!plan) {
-    plan = fftw_plan_dft_r2c_1d(N, in->data(),
-                                reinterpret_cast<fftw_complex*>(out->data()),
-                                FFTW_ESTIMATE);
+  T* x = in->data();
+  typename fftw_traits<T>::complex* y = fftw_traits<T>::cast(out->data());
+  const int align = plan_alignment<T>(x, y);
+  if (!plan || align != alignment) {
+    plan = shared_plan<T>(PlanKind::R2C, N, align, howmany, idist, odist);
+    alignment = align;
   }
-  fftw_execute(plan);
+  fftw_traits<T>::execute_r2c(plan, x, y);
 }
 
-FFT::~FFT()
-{
-  if (plan) {
-    fftw_destroy_plan(plan);
-  }
-}
+template class FFT<double>;
+template class FFT<float>;
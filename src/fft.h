@@ -20,11 +20,14 @@
 #include <complex>
 #include <vector>
 
-#include <fftw3.h>
+#include "aligned_vector.h"
+#include "fftw_traits.h"
 
 /**
  * @brief The FFT algorithm.
+ * @tparam T The precision of the samples, double or float.
  */
+template <typename T>
 class FFT {
  public:
   /**
@@ -32,10 +35,13 @@ class FFT {
    * @param N The length of the input frame / number of frequency bins.
    * @param in The input buffer with real data.
    * @param out The output buffer with complex data.
+   * @param howmany The number of transforms computed at once. The buffers are
+   * split evenly among them, so they must be sized before the construction.
    */
   FFT(unsigned N,
-      std::vector<double>& in,
-      std::vector<std::complex<double>>& out);
+      aligned_vector<T>& in,
+      aligned_vector<std::complex<T>>& out,
+      unsigned howmany = 1);
 
   /**
    * @brief Run the FFT algorithm.
@@ -45,17 +51,19 @@ class FFT {
    */
   void exec();
 
-  /**
-   * @brief Destructor.
-   */
-  ~FFT();
-
  private:
   unsigned N;
-  fftw_plan plan;
+  // the shared plan for the alignment of the buffers
+  typename fftw_traits<T>::plan plan;
+  int alignment;
+
+  unsigned howmany;
+  // the distances of the inputs and the outputs of the transforms
+  unsigned idist;
+  unsigned odist;
 
-  std::vector<double>* in;
-  std::vector<std::complex<double>>* out;
+  aligned_vector<T>* in;
+  aligned_vector<std::complex<T>>* out;
 };
 
 #endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file fftw_traits.h
+ * @brief The FFTW interface for the individual precisions.
+ */
+#ifndef FFTW_TRAITS_H
+#define FFTW_TRAITS_H
+
+#include <complex>
+#include <cstddef>
+
+#include <fftw3.h>
+
+/**
+ * @brief The FFTW types and functions for the given precision.
+ * The double precision uses the fftw_ functions, the single precision the
+ * fftwf_ functions.
+ * @tparam T The real type, double or float.
+ */
+template <typename T>
+struct fftw_traits;
+
+/**
+ * @brief Define the traits for a precision with the given function prefix.
+ */
+#define FFTW_TRAITS_DEF(type, prefix)                                         \
+  template <>                                                                 \
+  struct fftw_traits<type> {                                                  \
+    using plan = prefix##_plan;                                               \
+    using complex = prefix##_complex;                                         \
+                                                                              \
+    static complex* cast(std::complex<type>* x)                               \
+    {                                                                         \
+      return reinterpret_cast<complex*>(x);                                   \
+    }                                                                         \
+    static plan plan_r2c(int n, type* in, complex* out, unsigned flags)       \
+    {                                                                         \
+      return prefix##_plan_dft_r2c_1d(n, in, out, flags);                     \
+    }                                                                         \
+    static plan plan_c2r(int n, complex* in, type* out, unsigned flags)       \
+    {                                                                         \
+      return prefix##_plan_dft_c2r_1d(n, in, out, flags);                     \
+    }                                                                         \
+    static plan plan_r2r(int n,                                               \
+                         type* in,                                            \
+                         type* out,                                           \
+                         fftw_r2r_kind kind,                                  \
+                         unsigned flags)                                      \
+    {                                                                         \
+      return prefix##_plan_r2r_1d(n, in, out, kind, flags);                   \
+    }                                                                         \
+    static plan plan_many_r2c(int n,                                          \
+                              int howmany,                                    \
+                              type* in,                                       \
+                              int idist,                                      \
+                              complex* out,                                   \
+                              int odist,                                      \
+                              unsigned flags)                                 \
+    {                                                                         \
+      return prefix##_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1,       \
+                                        idist, out, nullptr, 1, odist,        \
+                                        flags);                               \
+    }                                                                         \
+    static plan plan_many_c2r(int n,                                          \
+                              int howmany,                                    \
+                              complex* in,                                    \
+                              int idist,                                      \
+                              type* out,                                      \
+                              int odist,                                      \
+                              unsigned flags)                                 \
+    {                                                                         \
+      return prefix##_plan_many_dft_c2r(1, &n, howmany, in, nullptr, 1,       \
+                                        idist, out, nullptr, 1, odist,        \
+                                        flags);                               \
+    }                                                                         \
+    static plan plan_many_r2r(int n,                                          \
+                              int howmany,                                    \
+                              type* in,                                       \
+                              int idist,                                      \
+                              type* out,                                      \
+                              int odist,                                      \
+                              fftw_r2r_kind kind,                             \
+                              unsigned flags)                                 \
+    {                                                                         \
+      return prefix##_plan_many_r2r(1, &n, howmany, in, nullptr, 1, idist,    \
+                                    out, nullptr, 1, odist, &kind, flags);    \
+    }                                                                         \
+    static void execute_r2c(const plan p, type* in, complex* out)             \
+    {                                                                         \
+      prefix##_execute_dft_r2c(p, in, out);                                   \
+    }                                                                         \
+    static void execute_c2r(const plan p, complex* in, type* out)             \
+    {                                                                         \
+      prefix##_execute_dft_c2r(p, in, out);                                   \
+    }                                                                         \
+    static void execute_r2r(const plan p, type* in, type* out)                \
+    {                                                                         \
+      prefix##_execute_r2r(p, in, out);                                       \
+    }                                                                         \
+    static int alignment_of(type* p) { return prefix##_alignment_of(p); }     \
+    static void* malloc(std::size_t n) { return prefix##_malloc(n); }         \
+    static void free(void* p) { prefix##_free(p); }                           \
+    static int import_wisdom(const char* f)                                   \
+    {                                                                         \
+      return prefix##_import_wisdom_from_filename(f);                         \
+    }                                                                         \
+    static int export_wisdom(const char* f)                                   \
+    {                                                                         \
+      return prefix##_export_wisdom_to_filename(f);                           \
+    }                                                                         \
+  };
+
+FFTW_TRAITS_DEF(double, fftw)
+FFTW_TRAITS_DEF(float, fftwf)
+
+#endif  // FFTW_TRAITS_H
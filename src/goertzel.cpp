@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+
+#include "goertzel.h"
+
+template <typename T>
+Goertzel<T>::Goertzel(unsigned N, unsigned bin, const aligned_vector<T>& in)
+    : N(N),
+      coeff(2 * std::cos(2 * M_PI * bin / N)),
+      twiddle(std::polar<T>(1, 2 * M_PI * bin / N)),
+      in(&in)
+{
+}
+
+template <typename T>
+std::complex<T> Goertzel<T>::exec() const
+{
+  T s1 = 0;
+  T s2 = 0;
+  for (std::size_t i = 0; i < N; i++) {
+    const T s0 = (*in)[i] + coeff * s1 - s2;
+    s2 = s1;
+    s1 = s0;
+  }
+  return twiddle * s1 - s2;
+}
+
+template class Goertzel<double>;
+template class Goertzel<float>;
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+
+#include <complex>
+#include <vector>
+
+#include "aligned_vector.h"
+
+/**
+ * @brief The Goertzel algorithm.
+ *
+ * Computes a single DFT coefficient of a real signal. This is cheaper than
+ * the FFT when only a few frequency bins are needed.
+ * @tparam T The precision of the samples, double or float.
+ */
+template <typename T>
+class Goertzel {
+ public:
+  /**
+   * @brief Constructor.
+   * @param N The length of the input frame / number of frequency bins.
+   * @param bin The index of the frequency bin to compute.
+   * @param in The input buffer with real data.
+   */
+  Goertzel(unsigned N, unsigned bin, const aligned_vector<T>& in);
+
+  /**
+   * @brief Run the Goertzel algorithm.
+   * @return The DFT coefficient of the input buffer at the frequency bin, the
+   * same as the corresponding output of FFT.
+   */
+  std::complex<T> exec() const;
+
+ private:
+  unsigned N;
+  T coeff;
+  std::complex<T> twiddle;
+
+  const aligned_vector<T>* in;
+};
+
+#endif
@@ -31,6 +31,21 @@ bool VectorInBitStream::eof() const
   return index >= source.size();
 }
 
+SeekableInBitStream::SeekableInBitStream(const BitVector& source)
+    : InBitStream(), source(source)
+{
+}
+
+bool SeekableInBitStream::eof() const
+{
+  return index >= source.size();
+}
+
+void SeekableInBitStream::seek(std::size_t pos)
+{
+  index = pos;
+}
+
 LimitedInBitStream::LimitedInBitStream(std::shared_ptr<InBitStream> in,
                                              std::size_t limit)
     : InBitStream(), in(in), limit(limit)
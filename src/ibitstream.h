@@ -17,7 +17,9 @@
 #ifndef IBITSTREAM_H
 #define IBITSTREAM_H
 
+#include <algorithm>
 #include <bitset>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
 
@@ -35,6 +37,28 @@ class InBitStream {
    */
   inline virtual int next_bit() = 0;
 
+  /**
+   * @brief Retrieve the next bits in the stream at once.
+   *
+   * The bits are stored from the least significant one, the same as calling
+   * next_bit() for each of them. Fewer bits are read only at the end of the
+   * stream.
+   * @param bits The bits read, the others are zero.
+   * @param n The number of bits to read, at most 64.
+   * @return The number of bits read.
+   */
+  virtual unsigned next_bits(uint64_t& bits, unsigned n)
+  {
+    bits = 0;
+    for (unsigned i = 0; i < n; i++) {
+      const int bit = next_bit();
+      if (bit == EOF)
+        return i;
+      bits |= (uint64_t)bit << i;
+    }
+    return n;
+  }
+
   /**
    * @brief Query the current EOF status.
    * Returns true if the stream is at the end, else false.
@@ -63,6 +87,24 @@ class InBitStream {
         i = (i + 1) % 8;
         return bit;
       };
+      unsigned next_bits(uint64_t& bits, unsigned n) override
+      {
+        // the rest of the current byte at once
+        bits = 0;
+        unsigned got = 0;
+        while (got < n) {
+          if (i == 0) {
+            buff = is.get();
+            if (is.eof())
+              return got;
+          }
+          const unsigned take = std::min(n - got, 8u - i);
+          bits |= (uint64_t)((buff >> i) & ((1u << take) - 1)) << got;
+          i = (i + take) % 8;
+          got += take;
+        }
+        return got;
+      }
       bool eof() const override { return is.eof() && i == 8; }
 
      private:
@@ -91,6 +133,14 @@ class VectorInBitStream : public InBitStream {
     return EOF;
   }
 
+  unsigned next_bits(uint64_t& bits, unsigned n) override
+  {
+    n = std::min<std::size_t>(n, source.size() - index);
+    bits = source.read(index, n);
+    index += n;
+    return n;
+  }
+
   virtual bool eof() const override;
 
  private:
@@ -98,6 +148,44 @@ class VectorInBitStream : public InBitStream {
   std::size_t index = 0;
 };
 
+/**
+ * @brief InBitStream reading a BitVector shared with other streams.
+ * The stream can be moved to any position in the source, the source is not
+ * copied and must outlive the stream.
+ */
+class SeekableInBitStream : public InBitStream {
+ public:
+  SeekableInBitStream(const BitVector& source);
+
+  inline virtual int next_bit() override
+  {
+    if (index < source.size()) {
+      return source[index++];
+    }
+    return EOF;
+  }
+
+  unsigned next_bits(uint64_t& bits, unsigned n) override
+  {
+    n = std::min<std::size_t>(n, source.size() - index);
+    bits = source.read(index, n);
+    index += n;
+    return n;
+  }
+
+  virtual bool eof() const override;
+
+  /**
+   * @brief Move to the given position in the source.
+   * @param pos The index of the next bit to read.
+   */
+  void seek(std::size_t pos);
+
+ private:
+  const BitVector& source;
+  std::size_t index = 0;
+};
+
 /**
  * @brief An InBitStream decorator which EOFs after the given number of bits were read.
  */
@@ -114,6 +202,17 @@ class LimitedInBitStream : public InBitStream {
     return in->next_bit();
   }
 
+  unsigned next_bits(uint64_t& bits, unsigned n) override
+  {
+    bits = 0;
+    if (eof())
+      return 0;
+    n = std::min<std::size_t>(n, limit - count);
+    const unsigned got = in->next_bits(bits, n);
+    count += got;
+    return got;
+  }
+
   virtual bool eof() const override;
 
  private:
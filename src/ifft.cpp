@@ -15,30 +15,43 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "ifft.h"
+#include "planner.h"
 
-IFFT::IFFT(unsigned N,
-           std::vector<std::complex<double>>& in,
-           std::vector<double>& out)
-    : N(N), plan(0), in(&in), out(&out)
+template <typename T>
+IFFT<T>::IFFT(unsigned N,
+              aligned_vector<std::complex<T>>& in,
+              aligned_vector<T>& out,
+              unsigned howmany)
+    : N(N),
+      plan(0),
+      alignment(0),
+      howmany(howmany),
+      idist(in.size() / howmany),
+      odist(out.size() / howmany),
+      in(&in),
+      out(&out)
 {
 }
 
-void IFFT::exec()
+template <typename T>
+void IFFT<T>::exec()
 {
-  if (!plan) {
-    plan = fftw_plan_dft_c2r_1d(N, reinterpret_cast<fftw_complex*>(in->data()),
-                                out->data(), FFTW_ESTIMATE);
+  typename fftw_traits<T>::complex* x = fftw_traits<T>::cast(in->data());
+  T* y = out->data();
+  const int align = plan_alignment<T>(x, y);
+  if (!plan || align != alignment) {
+    plan = shared_plan<T>(PlanKind::C2R, N, align, howmany, idist, odist);
+    alignment = align;
   }
-  fftw_execute(plan);
+  fftw_traits<T>::execute_c2r(plan, x, y);
   // fftw doesn't normalize, we have to
-  for (std::size_t i = 0; i < N; i++) {
-    (*out)[i] /= N;
+  for (std::size_t h = 0; h < howmany; h++) {
+    T* frame = y + h * odist;
+    for (std::size_t i = 0; i < N; i++) {
+      frame[i] /= N;
+    }
   }
 }
 
-IFFT::~IFFT()
-{
-  if (plan) {
-    fftw_destroy_plan(plan);
-  }
-}
+template class IFFT<double>;
+template class IFFT<float>;
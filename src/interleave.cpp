@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+
+#include "interleave.h"
+
+#if defined(__x86_64__)
+// the kernels of the instruction sets, see interleave_kernels.h, false if
+// there is none for the channel count
+template <typename T>
+bool deinterleave_sse2(const T* in,
+                       T* planar,
+                       std::size_t frames,
+                       int channels);
+template <typename T>
+bool interleave_sse2(const T* planar, T* out, std::size_t frames, int channels);
+template <typename T>
+bool deinterleave_avx2(const T* in,
+                       T* planar,
+                       std::size_t frames,
+                       int channels);
+template <typename T>
+bool interleave_avx2(const T* planar, T* out, std::size_t frames, int channels);
+template <typename T>
+bool deinterleave_avx512(const T* in,
+                         T* planar,
+                         std::size_t frames,
+                         int channels);
+template <typename T>
+bool interleave_avx512(const T* planar,
+                       T* out,
+                       std::size_t frames,
+                       int channels);
+#endif
+
+static SimdLevel detect_simd_level()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return SimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::AVX2;
+  // part of x86-64
+  return SimdLevel::SSE2;
+#else
+  return SimdLevel::SCALAR;
+#endif
+}
+
+SimdLevel simd_level()
+{
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+const char* simd_name(SimdLevel level)
+{
+  switch (level) {
+    case SimdLevel::SSE2:
+      return "sse2";
+    case SimdLevel::AVX2:
+      return "avx2";
+    case SimdLevel::AVX512:
+      return "avx512";
+    default:
+      return "scalar";
+  }
+}
+
+/**
+ * Deinterleave a fixed number of channels, which the compiler can unroll.
+ */
+template <typename T, int C>
+static void deinterleave_fixed(const T* in, T* planar, std::size_t frames)
+{
+  for (std::size_t i = 0; i < frames; i++) {
+    for (int ch = 0; ch < C; ch++) {
+      planar[ch * frames + i] = in[i * C + ch];
+    }
+  }
+}
+
+/**
+ * Interleave a fixed number of channels, which the compiler can unroll.
+ */
+template <typename T, int C>
+static void interleave_fixed(const T* planar, T* out, std::size_t frames)
+{
+  for (std::size_t i = 0; i < frames; i++) {
+    for (int ch = 0; ch < C; ch++) {
+      out[i * C + ch] = planar[ch * frames + i];
+    }
+  }
+}
+
+template <typename T>
+static void deinterleave_scalar(const T* in,
+                                T* planar,
+                                std::size_t frames,
+                                int channels)
+{
+  switch (channels) {
+    case 2:
+      deinterleave_fixed<T, 2>(in, planar, frames);
+      return;
+    case 4:
+      deinterleave_fixed<T, 4>(in, planar, frames);
+      return;
+    case 6:
+      deinterleave_fixed<T, 6>(in, planar, frames);
+      return;
+    case 8:
+      deinterleave_fixed<T, 8>(in, planar, frames);
+      return;
+  }
+
+  // a single sequential pass over the input
+  for (std::size_t i = 0; i < frames; i++) {
+    for (int ch = 0; ch < channels; ch++) {
+      planar[ch * frames + i] = in[i * channels + ch];
+    }
+  }
+}
+
+template <typename T>
+static void interleave_scalar(const T* planar,
+                              T* out,
+                              std::size_t frames,
+                              int channels)
+{
+  switch (channels) {
+    case 2:
+      interleave_fixed<T, 2>(planar, out, frames);
+      return;
+    case 4:
+      interleave_fixed<T, 4>(planar, out, frames);
+      return;
+    case 6:
+      interleave_fixed<T, 6>(planar, out, frames);
+      return;
+    case 8:
+      interleave_fixed<T, 8>(planar, out, frames);
+      return;
+  }
+
+  // a single sequential pass over the output
+  for (std::size_t i = 0; i < frames; i++) {
+    for (int ch = 0; ch < channels; ch++) {
+      out[i * channels + ch] = planar[ch * frames + i];
+    }
+  }
+}
+
+template <typename T>
+void deinterleave(const T* in, T* planar, std::size_t frames, int channels)
+{
+  deinterleave(in, planar, frames, channels, simd_level());
+}
+
+template <typename T>
+void deinterleave(const T* in,
+                  T* planar,
+                  std::size_t frames,
+                  int channels,
+                  SimdLevel level)
+{
+  if (channels == 1) {
+    std::copy(in, in + frames, planar);
+    return;
+  }
+
+  bool done = false;
+  switch (level) {
+#if defined(__x86_64__)
+    case SimdLevel::AVX512:
+      done = deinterleave_avx512(in, planar, frames, channels);
+      break;
+    case SimdLevel::AVX2:
+      done = deinterleave_avx2(in, planar, frames, channels);
+      break;
+    case SimdLevel::SSE2:
+      done = deinterleave_sse2(in, planar, frames, channels);
+      break;
+#endif
+    default:
+      break;
+  }
+  if (!done)
+    deinterleave_scalar(in, planar, frames, channels);
+}
+
+template <typename T>
+void interleave(const T* planar, T* out, std::size_t frames, int channels)
+{
+  interleave(planar, out, frames, channels, simd_level());
+}
+
+template <typename T>
+void interleave(const T* planar,
+                T* out,
+                std::size_t frames,
+                int channels,
+                SimdLevel level)
+{
+  if (channels == 1) {
+    std::copy(planar, planar + frames, out);
+    return;
+  }
+
+  bool done = false;
+  switch (level) {
+#if defined(__x86_64__)
+    case SimdLevel::AVX512:
+      done = interleave_avx512(planar, out, frames, channels);
+      break;
+    case SimdLevel::AVX2:
+      done = interleave_avx2(planar, out, frames, channels);
+      break;
+    case SimdLevel::SSE2:
+      done = interleave_sse2(planar, out, frames, channels);
+      break;
+#endif
+    default:
+      break;
+  }
+  if (!done)
+    interleave_scalar(planar, out, frames, channels);
+}
+
+template void deinterleave(const int16_t*, int16_t*, std::size_t, int);
+template void deinterleave(const int16_t*,
+                           int16_t*,
+                           std::size_t,
+                           int,
+                           SimdLevel);
+template void interleave(const int16_t*, int16_t*, std::size_t, int);
+template void interleave(const int16_t*,
+                         int16_t*,
+                         std::size_t,
+                         int,
+                         SimdLevel);
+
+template void deinterleave(const int32_t*, int32_t*, std::size_t, int);
+template void deinterleave(const int32_t*,
+                           int32_t*,
+                           std::size_t,
+                           int,
+                           SimdLevel);
+template void interleave(const int32_t*, int32_t*, std::size_t, int);
+template void interleave(const int32_t*,
+                         int32_t*,
+                         std::size_t,
+                         int,
+                         SimdLevel);
+
+template void deinterleave(const float*, float*, std::size_t, int);
+template void deinterleave(const float*, float*, std::size_t, int, SimdLevel);
+template void interleave(const float*, float*, std::size_t, int);
+template void interleave(const float*, float*, std::size_t, int, SimdLevel);
+
+template void deinterleave(const double*, double*, std::size_t, int);
+template void deinterleave(const double*,
+                           double*,
+                           std::size_t,
+                           int,
+                           SimdLevel);
+template void interleave(const double*, double*, std::size_t, int);
+template void interleave(const double*, double*, std::size_t, int, SimdLevel);
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file interleave.h
+ * @brief Conversion of interleaved signal to planar blocks of channels and
+ * back.
+ *
+ * The conversions of 1, 2, 4, 6 and 8 channels of int16_t, int32_t, float
+ * and double samples have kernels for SSE2, AVX2 and AVX-512, the best one
+ * supported by the CPU is selected at runtime. Other channel counts and CPUs
+ * use portable loops.
+ */
+#ifndef INTERLEAVE_H
+#define INTERLEAVE_H
+
+#include <cstddef>
+
+/**
+ * @brief The instruction sets of the kernels.
+ */
+enum class SimdLevel {
+  SCALAR,  // portable loops
+  SSE2,
+  AVX2,
+  AVX512,  // AVX-512F
+};
+
+/**
+ * @brief Get the best instruction set supported by the CPU, detected once.
+ */
+SimdLevel simd_level();
+
+/**
+ * @brief Get the name of the instruction set.
+ */
+const char* simd_name(SimdLevel level);
+
+/**
+ * Deinterleave all channels of a part of interleaved signal into a planar
+ * block, the channels one after another.
+ * @param in The interleaved signal.
+ * @param planar The buffer for the channels.
+ * @param frames The number of samples in each channel.
+ * @param channels The total number of channels in the input signal.
+ */
+template <typename T>
+void deinterleave(const T* in, T* planar, std::size_t frames, int channels);
+
+/**
+ * Deinterleave with the kernels of the given instruction set, see
+ * deinterleave(). The CPU has to support the instruction set.
+ */
+template <typename T>
+void deinterleave(const T* in,
+                  T* planar,
+                  std::size_t frames,
+                  int channels,
+                  SimdLevel level);
+
+/**
+ * Interleave a planar block of channels into a part of signal.
+ * @param planar The channels, one after another.
+ * @param out The signal to interleave.
+ * @param frames The number of samples in each channel.
+ * @param channels The total number of channels in the output signal.
+ */
+template <typename T>
+void interleave(const T* planar, T* out, std::size_t frames, int channels);
+
+/**
+ * Interleave with the kernels of the given instruction set, see interleave().
+ * The CPU has to support the instruction set.
+ */
+template <typename T>
+void interleave(const T* planar,
+                T* out,
+                std::size_t frames,
+                int channels,
+                SimdLevel level);
+
+/**
+ * Deinterleave consecutive frames of interleaved signal, each frame into a
+ * planar block of its own, see deinterleave().
+ * @param in The interleaved signal.
+ * @param planar The buffer for the frames.
+ * @param frames The number of frames.
+ * @param frame_size The number of samples in each channel of a frame.
+ * @param channels The total number of channels in the input signal.
+ */
+template <typename T>
+void deinterleave_frames(const T* in,
+                         T* planar,
+                         std::size_t frames,
+                         std::size_t frame_size,
+                         int channels)
+{
+  const std::size_t frame_len = frame_size * channels;
+  for (std::size_t f = 0; f < frames; f++) {
+    deinterleave(in + f * frame_len, planar + f * frame_len, frame_size,
+                 channels);
+  }
+}
+
+/**
+ * Interleave consecutive planar frames into a part of signal, see
+ * interleave().
+ * @param planar The frames, one after another.
+ * @param out The signal to interleave.
+ * @param frames The number of frames.
+ * @param frame_size The number of samples in each channel of a frame.
+ * @param channels The total number of channels in the output signal.
+ */
+template <typename T>
+void interleave_frames(const T* planar,
+                       T* out,
+                       std::size_t frames,
+                       std::size_t frame_size,
+                       int channels)
+{
+  const std::size_t frame_len = frame_size * channels;
+  for (std::size_t f = 0; f < frames; f++) {
+    interleave(planar + f * frame_len, out + f * frame_len, frame_size,
+               channels);
+  }
+}
+
+#endif  // INTERLEAVE_H
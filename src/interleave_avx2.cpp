@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// the AVX2 kernels, see interleave_kernels.h
+#include <cstdint>
+
+#include "interleave_kernels.h"
+
+template <typename T>
+bool deinterleave_avx2(const T* in, T* planar, std::size_t frames, int channels)
+{
+  return deinterleave_simd(in, planar, frames, channels);
+}
+
+template <typename T>
+bool interleave_avx2(const T* planar, T* out, std::size_t frames, int channels)
+{
+  return interleave_simd(planar, out, frames, channels);
+}
+
+template bool deinterleave_avx2(const int16_t*, int16_t*, std::size_t, int);
+template bool deinterleave_avx2(const int32_t*, int32_t*, std::size_t, int);
+template bool deinterleave_avx2(const float*, float*, std::size_t, int);
+template bool deinterleave_avx2(const double*, double*, std::size_t, int);
+template bool interleave_avx2(const int16_t*, int16_t*, std::size_t, int);
+template bool interleave_avx2(const int32_t*, int32_t*, std::size_t, int);
+template bool interleave_avx2(const float*, float*, std::size_t, int);
+template bool interleave_avx2(const double*, double*, std::size_t, int);
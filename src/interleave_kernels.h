@@ -0,0 +1,653 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file interleave_kernels.h
+ * @brief The SIMD kernels of interleave.h for the instruction set the
+ * translation unit is compiled for.
+ *
+ * Included only by interleave_sse2.cpp, interleave_avx2.cpp and
+ * interleave_avx512.cpp, which are compiled with different instruction sets.
+ * Everything here has internal linkage and no inline functions of other
+ * headers are used, their instances could otherwise be shared with the code
+ * running on any CPU.
+ */
+#ifndef INTERLEAVE_KERNELS_H
+#define INTERLEAVE_KERNELS_H
+
+#include <immintrin.h>
+
+#include <climits>
+#include <cstddef>
+
+namespace {
+
+/**
+ * @brief The vector registers of the instruction set, by the size of the
+ * samples.
+ *
+ * Each provides the number of lanes, unaligned load and store, and unzip and
+ * zip of two registers:
+ *  - unzip(a, b) gives the even lanes of a then b, and the odd lanes of a then
+ *    b,
+ *  - zip(a, b) gives the interleaved lower halves of a and b, and the
+ *    interleaved upper halves.
+ *
+ * The unzip and zip work on each of the blocks of lanes of the registers on
+ * its own, which are loaded from and stored to separate addresses, so that no
+ * shuffles across the 128-bit halves of the AVX2 registers are needed.
+ *
+ * If the instruction set has gathers, index is a vector of 32-bit offsets for
+ * gather(). The gathers are masked with a zeroed source, the unmasked ones
+ * trip -Wmaybe-uninitialized of GCC.
+ */
+template <std::size_t Size>
+struct Vec;
+
+#if defined(__AVX512F__)
+
+template <>
+struct Vec<4> {
+  using reg = __m512;
+  using index = __m512i;
+  static constexpr std::size_t lanes = 16;
+  static constexpr std::size_t blocks = 1;
+  static constexpr bool has_gather = true;
+
+  static reg load(const void* p) { return _mm512_loadu_ps(p); }
+  static void store(void* p, reg x) { _mm512_storeu_ps(p, x); }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    const __m512i ie = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18,
+                                         20, 22, 24, 26, 28, 30);
+    const __m512i io = _mm512_add_epi32(ie, _mm512_set1_epi32(1));
+    even = _mm512_permutex2var_ps(a, ie, b);
+    odd = _mm512_permutex2var_ps(a, io, b);
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    const __m512i il = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5,
+                                         21, 6, 22, 7, 23);
+    const __m512i ih = _mm512_add_epi32(il, _mm512_set1_epi32(8));
+    lo = _mm512_permutex2var_ps(a, il, b);
+    hi = _mm512_permutex2var_ps(a, ih, b);
+  }
+
+  static index make_index(const int* offsets)
+  {
+    return _mm512_loadu_si512(offsets);
+  }
+  static reg gather(const void* base, index idx)
+  {
+    return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, idx, base, 4);
+  }
+};
+
+template <>
+struct Vec<8> {
+  using reg = __m512d;
+  using index = __m256i;
+  static constexpr std::size_t lanes = 8;
+  static constexpr std::size_t blocks = 1;
+  static constexpr bool has_gather = true;
+
+  static reg load(const void* p) { return _mm512_loadu_pd(p); }
+  static void store(void* p, reg x) { _mm512_storeu_pd(p, x); }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    const __m512i ie = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m512i io = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+    even = _mm512_permutex2var_pd(a, ie, b);
+    odd = _mm512_permutex2var_pd(a, io, b);
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    const __m512i il = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+    const __m512i ih = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+    lo = _mm512_permutex2var_pd(a, il, b);
+    hi = _mm512_permutex2var_pd(a, ih, b);
+  }
+
+  static index make_index(const int* offsets)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets));
+  }
+  static reg gather(const void* base, index idx)
+  {
+    return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, idx, base, 8);
+  }
+};
+
+#elif defined(__AVX2__)
+
+template <>
+struct Vec<4> {
+  using reg = __m256;
+  using index = __m256i;
+  static constexpr std::size_t lanes = 8;
+  static constexpr std::size_t blocks = 2;
+  static constexpr bool has_gather = true;
+
+  static reg load(const void* p)
+  {
+    return _mm256_loadu_ps(static_cast<const float*>(p));
+  }
+  static reg load(const void* lo, const void* hi)
+  {
+    return _mm256_loadu2_m128(static_cast<const float*>(hi),
+                              static_cast<const float*>(lo));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm256_storeu_ps(static_cast<float*>(p), x);
+  }
+  static void store(void* lo, void* hi, reg x)
+  {
+    _mm256_storeu2_m128(static_cast<float*>(hi), static_cast<float*>(lo), x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm256_unpacklo_ps(a, b);
+    hi = _mm256_unpackhi_ps(a, b);
+  }
+
+  static index make_index(const int* offsets)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets));
+  }
+  static reg gather(const void* base, index idx)
+  {
+    const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    return _mm256_mask_i32gather_ps(_mm256_setzero_ps(),
+                                    static_cast<const float*>(base), idx, all,
+                                    4);
+  }
+};
+
+template <>
+struct Vec<8> {
+  using reg = __m256d;
+  using index = __m128i;
+  static constexpr std::size_t lanes = 4;
+  static constexpr std::size_t blocks = 2;
+  static constexpr bool has_gather = true;
+
+  static reg load(const void* p)
+  {
+    return _mm256_loadu_pd(static_cast<const double*>(p));
+  }
+  static reg load(const void* lo, const void* hi)
+  {
+    return _mm256_loadu2_m128d(static_cast<const double*>(hi),
+                               static_cast<const double*>(lo));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm256_storeu_pd(static_cast<double*>(p), x);
+  }
+  static void store(void* lo, void* hi, reg x)
+  {
+    _mm256_storeu2_m128d(static_cast<double*>(hi), static_cast<double*>(lo),
+                         x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    even = _mm256_unpacklo_pd(a, b);
+    odd = _mm256_unpackhi_pd(a, b);
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm256_unpacklo_pd(a, b);
+    hi = _mm256_unpackhi_pd(a, b);
+  }
+
+  static index make_index(const int* offsets)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets));
+  }
+  static reg gather(const void* base, index idx)
+  {
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(),
+                                    static_cast<const double*>(base), idx,
+                                    all, 8);
+  }
+};
+
+#endif
+
+#if defined(__AVX2__)
+
+// AVX-512F has no 16-bit shuffles, the AVX-512 kernels use the AVX2 ones
+template <>
+struct Vec<2> {
+  using reg = __m256i;
+  static constexpr std::size_t lanes = 16;
+  static constexpr std::size_t blocks = 2;
+  static constexpr bool has_gather = false;
+
+  static reg load(const void* p)
+  {
+    return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+  }
+  static reg load(const void* lo, const void* hi)
+  {
+    return _mm256_loadu2_m128i(static_cast<const __m128i*>(hi),
+                               static_cast<const __m128i*>(lo));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm256_storeu_si256(static_cast<__m256i*>(p), x);
+  }
+  static void store(void* lo, void* hi, reg x)
+  {
+    _mm256_storeu2_m128i(static_cast<__m128i*>(hi), static_cast<__m128i*>(lo),
+                         x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    // the sign-extended halves of the 32-bit lanes are packed without
+    // saturating
+    even = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16),
+                              _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16));
+    odd = _mm256_packs_epi32(_mm256_srai_epi32(a, 16),
+                             _mm256_srai_epi32(b, 16));
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm256_unpacklo_epi16(a, b);
+    hi = _mm256_unpackhi_epi16(a, b);
+  }
+};
+
+#else  // SSE2
+
+template <>
+struct Vec<2> {
+  using reg = __m128i;
+  static constexpr std::size_t lanes = 8;
+  static constexpr std::size_t blocks = 1;
+  static constexpr bool has_gather = false;
+
+  static reg load(const void* p)
+  {
+    return _mm_loadu_si128(static_cast<const __m128i*>(p));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm_storeu_si128(static_cast<__m128i*>(p), x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    // the sign-extended halves of the 32-bit lanes are packed without
+    // saturating
+    even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                           _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+    odd = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm_unpacklo_epi16(a, b);
+    hi = _mm_unpackhi_epi16(a, b);
+  }
+};
+
+template <>
+struct Vec<4> {
+  using reg = __m128;
+  static constexpr std::size_t lanes = 4;
+  static constexpr std::size_t blocks = 1;
+  static constexpr bool has_gather = false;
+
+  static reg load(const void* p)
+  {
+    return _mm_loadu_ps(static_cast<const float*>(p));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm_storeu_ps(static_cast<float*>(p), x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm_unpacklo_ps(a, b);
+    hi = _mm_unpackhi_ps(a, b);
+  }
+};
+
+template <>
+struct Vec<8> {
+  using reg = __m128d;
+  static constexpr std::size_t lanes = 2;
+  static constexpr std::size_t blocks = 1;
+  static constexpr bool has_gather = false;
+
+  static reg load(const void* p)
+  {
+    return _mm_loadu_pd(static_cast<const double*>(p));
+  }
+  static void store(void* p, reg x)
+  {
+    _mm_storeu_pd(static_cast<double*>(p), x);
+  }
+
+  static void unzip(reg a, reg b, reg& even, reg& odd)
+  {
+    even = _mm_unpacklo_pd(a, b);
+    odd = _mm_unpackhi_pd(a, b);
+  }
+
+  static void zip(reg a, reg b, reg& lo, reg& hi)
+  {
+    lo = _mm_unpacklo_pd(a, b);
+    hi = _mm_unpackhi_pd(a, b);
+  }
+};
+
+#endif
+
+/**
+ * Deinterleave the frames from the given one on, one by one.
+ */
+template <typename T>
+void deinterleave_tail(const T* in,
+                       T* planar,
+                       std::size_t from,
+                       std::size_t frames,
+                       int channels)
+{
+  for (std::size_t i = from; i < frames; i++) {
+    for (int ch = 0; ch < channels; ch++) {
+      planar[ch * frames + i] = in[i * channels + ch];
+    }
+  }
+}
+
+/**
+ * Interleave the frames from the given one on, one by one.
+ */
+template <typename T>
+void interleave_tail(const T* planar,
+                     T* out,
+                     std::size_t from,
+                     std::size_t frames,
+                     int channels)
+{
+  for (std::size_t i = from; i < frames; i++) {
+    for (int ch = 0; ch < channels; ch++) {
+      out[i * channels + ch] = planar[ch * frames + i];
+    }
+  }
+}
+
+/**
+ * Load a register of interleaved samples, its blocks the given number of
+ * samples apart.
+ */
+template <typename V, typename T>
+typename V::reg load_blocks(const T* p, std::size_t stride)
+{
+  if constexpr (V::blocks == 2)
+    return V::load(p, p + stride);
+  else
+    return V::load(p);
+}
+
+/**
+ * Store a register of interleaved samples, its blocks the given number of
+ * samples apart.
+ */
+template <typename V, typename T>
+void store_blocks(T* p, std::size_t stride, typename V::reg x)
+{
+  if constexpr (V::blocks == 2)
+    V::store(p, p + stride, x);
+  else
+    V::store(p, x);
+}
+
+/**
+ * Deinterleave a power of two of channels.
+ *
+ * The C registers holding as many frames in each block are transposed by
+ * log2(C) rounds of unzipping the neighbouring registers, each round rotates
+ * the bits of the index of a sample in a block by one, moving the channel
+ * from the lowest bits to the highest. The blocks hold consecutive frames, so
+ * each register ends up holding consecutive samples of a channel.
+ */
+template <typename T, int C>
+void deinterleave_pow2(const T* in, T* planar, std::size_t frames)
+{
+  using V = Vec<sizeof(T)>;
+  constexpr std::size_t L = V::lanes;
+  // the lanes of each block
+  constexpr std::size_t B = L / V::blocks;
+
+  std::size_t i = 0;
+  for (; i + L <= frames; i += L) {
+    typename V::reg x[C], y[C];
+#pragma GCC unroll 8
+    for (int v = 0; v < C; v++) {
+      x[v] = load_blocks<V>(in + i * C + v * B, B * C);
+    }
+#pragma GCC unroll 3
+    for (int round = 1; round < C; round <<= 1) {
+#pragma GCC unroll 4
+      for (int j = 0; j < C / 2; j++) {
+        V::unzip(x[2 * j], x[2 * j + 1], y[j], y[j + C / 2]);
+      }
+#pragma GCC unroll 8
+      for (int v = 0; v < C; v++) {
+        x[v] = y[v];
+      }
+    }
+#pragma GCC unroll 8
+    for (int ch = 0; ch < C; ch++) {
+      V::store(planar + ch * frames + i, x[ch]);
+    }
+  }
+  deinterleave_tail(in, planar, i, frames, C);
+}
+
+/**
+ * Interleave a power of two of channels, the inverse of deinterleave_pow2().
+ */
+template <typename T, int C>
+void interleave_pow2(const T* planar, T* out, std::size_t frames)
+{
+  using V = Vec<sizeof(T)>;
+  constexpr std::size_t L = V::lanes;
+  constexpr std::size_t B = L / V::blocks;
+
+  std::size_t i = 0;
+  for (; i + L <= frames; i += L) {
+    typename V::reg x[C], y[C];
+#pragma GCC unroll 8
+    for (int ch = 0; ch < C; ch++) {
+      x[ch] = V::load(planar + ch * frames + i);
+    }
+#pragma GCC unroll 3
+    for (int round = 1; round < C; round <<= 1) {
+#pragma GCC unroll 4
+      for (int j = 0; j < C / 2; j++) {
+        V::zip(x[j], x[j + C / 2], y[2 * j], y[2 * j + 1]);
+      }
+#pragma GCC unroll 8
+      for (int v = 0; v < C; v++) {
+        x[v] = y[v];
+      }
+    }
+#pragma GCC unroll 8
+    for (int v = 0; v < C; v++) {
+      store_blocks<V>(out + i * C + v * B, B * C, x[v]);
+    }
+  }
+  interleave_tail(planar, out, i, frames, C);
+}
+
+/**
+ * Deinterleave any number of channels by gathering each channel with stride.
+ */
+template <typename T, int C>
+void deinterleave_gather(const T* in, T* planar, std::size_t frames)
+{
+  using V = Vec<sizeof(T)>;
+  constexpr std::size_t L = V::lanes;
+
+  int offsets[L];
+  for (std::size_t l = 0; l < L; l++) {
+    offsets[l] = l * C;
+  }
+  const typename V::index idx = V::make_index(offsets);
+
+  std::size_t i = 0;
+  for (; i + L <= frames; i += L) {
+#pragma GCC unroll 8
+    for (int ch = 0; ch < C; ch++) {
+      V::store(planar + ch * frames + i, V::gather(in + i * C + ch, idx));
+    }
+  }
+  deinterleave_tail(in, planar, i, frames, C);
+}
+
+/**
+ * Interleave an even number of channels by gathering each register of the
+ * output from the channels.
+ *
+ * The pattern of the offsets repeats every C registers of the output, or
+ * C / 2 registers for an even number of channels, holding L / 2 frames.
+ */
+template <typename T, int C>
+void interleave_gather(const T* planar, T* out, std::size_t frames)
+{
+  static_assert(C % 2 == 0, "the pattern assumes an even channel count");
+  using V = Vec<sizeof(T)>;
+  constexpr std::size_t L = V::lanes;
+  constexpr int R = C / 2;
+
+  typename V::index idx[R];
+  for (int v = 0; v < R; v++) {
+    int offsets[L];
+    for (std::size_t l = 0; l < L; l++) {
+      const std::size_t k = v * L + l;
+      offsets[l] = (k % C) * frames + k / C;
+    }
+    idx[v] = V::make_index(offsets);
+  }
+
+  std::size_t i = 0;
+  for (; i + L / 2 <= frames; i += L / 2) {
+#pragma GCC unroll 4
+    for (int v = 0; v < R; v++) {
+      V::store(out + i * C + v * L, V::gather(planar + i, idx[v]));
+    }
+  }
+  interleave_tail(planar, out, i, frames, C);
+}
+
+/**
+ * Deinterleave with the kernel for the channel count, if there is one.
+ * @return Whether the signal was deinterleaved.
+ */
+template <typename T>
+bool deinterleave_simd(const T* in,
+                       T* planar,
+                       std::size_t frames,
+                       int channels)
+{
+  switch (channels) {
+    case 2:
+      deinterleave_pow2<T, 2>(in, planar, frames);
+      return true;
+    case 4:
+      deinterleave_pow2<T, 4>(in, planar, frames);
+      return true;
+    case 6:
+      // the offsets of the gathers are 32-bit
+      if constexpr (Vec<sizeof(T)>::has_gather) {
+        if (frames <= INT_MAX / 6) {
+          deinterleave_gather<T, 6>(in, planar, frames);
+          return true;
+        }
+      }
+      return false;
+    case 8:
+      deinterleave_pow2<T, 8>(in, planar, frames);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Interleave with the kernel for the channel count, if there is one.
+ * @return Whether the signal was interleaved.
+ */
+template <typename T>
+bool interleave_simd(const T* planar,
+                     T* out,
+                     std::size_t frames,
+                     int channels)
+{
+  switch (channels) {
+    case 2:
+      interleave_pow2<T, 2>(planar, out, frames);
+      return true;
+    case 4:
+      interleave_pow2<T, 4>(planar, out, frames);
+      return true;
+    case 6:
+      if constexpr (Vec<sizeof(T)>::has_gather) {
+        if (frames <= INT_MAX / 6) {
+          interleave_gather<T, 6>(planar, out, frames);
+          return true;
+        }
+      }
+      return false;
+    case 8:
+      interleave_pow2<T, 8>(planar, out, frames);
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+#endif  // INTERLEAVE_KERNELS_H
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <type_traits>
+
+#include "lsb_bits.h"
+
+#if defined(__x86_64__)
+// the kernels of lsb_bits_bmi2.cpp, n is a multiple of the samples in 64 bits
+template <typename T>
+void deposit_lsbs_bmi2(const T* in,
+                       T* out,
+                       std::size_t n,
+                       uint64_t bits,
+                       unsigned lsbs,
+                       unsigned shift);
+template <typename T>
+uint64_t extract_lsbs_bmi2(const T* in,
+                           std::size_t n,
+                           unsigned lsbs,
+                           unsigned shift);
+#endif
+
+static bool detect_fast_bmi2()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  // pdep and pext are microcoded on AMD CPUs before Zen 3, slower than the
+  // portable loops
+  return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("amdfam15h") &&
+         !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+#else
+  return false;
+#endif
+}
+
+bool lsb_bmi2()
+{
+  static const bool fast = detect_fast_bmi2();
+  return fast;
+}
+
+template <typename T>
+static void deposit_lsbs_scalar(const T* in,
+                                T* out,
+                                std::size_t n,
+                                uint64_t bits,
+                                unsigned lsbs,
+                                unsigned shift)
+{
+  using U = typename std::make_unsigned<T>::type;
+  const U mask = ((U)1 << lsbs) - 1;
+  const U keep = ~(U)(((uint64_t)2 << (lsbs + shift)) - 1);
+  for (std::size_t i = 0; i < n; i++) {
+    const U lsb = (bits >> (i * lsbs)) & mask;
+    out[i] = static_cast<T>(((U)in[i] & keep) | (U)(lsb << shift));
+  }
+}
+
+template <typename T>
+static uint64_t extract_lsbs_scalar(const T* in,
+                                    std::size_t n,
+                                    unsigned lsbs,
+                                    unsigned shift)
+{
+  using U = typename std::make_unsigned<T>::type;
+  const U mask = ((U)1 << lsbs) - 1;
+  uint64_t bits = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    bits |= (uint64_t)(((U)in[i] >> shift) & mask) << (i * lsbs);
+  }
+  return bits;
+}
+
+template <typename T>
+void deposit_lsbs(const T* in,
+                  T* out,
+                  std::size_t n,
+                  uint64_t bits,
+                  unsigned lsbs,
+                  unsigned shift)
+{
+  deposit_lsbs(in, out, n, bits, lsbs, shift, lsb_bmi2());
+}
+
+template <typename T>
+void deposit_lsbs(const T* in,
+                  T* out,
+                  std::size_t n,
+                  uint64_t bits,
+                  unsigned lsbs,
+                  unsigned shift,
+                  bool bmi2)
+{
+  std::size_t i = 0;
+#if defined(__x86_64__)
+  if (bmi2) {
+    i = n - n % (sizeof(uint64_t) / sizeof(T));
+    deposit_lsbs_bmi2(in, out, i, bits, lsbs, shift);
+  }
+#else
+  (void)bmi2;
+#endif
+  if (i < n)
+    deposit_lsbs_scalar(in + i, out + i, n - i, bits >> (i * lsbs), lsbs,
+                        shift);
+}
+
+template <typename T>
+uint64_t extract_lsbs(const T* in,
+                      std::size_t n,
+                      unsigned lsbs,
+                      unsigned shift)
+{
+  return extract_lsbs(in, n, lsbs, shift, lsb_bmi2());
+}
+
+template <typename T>
+uint64_t extract_lsbs(const T* in,
+                      std::size_t n,
+                      unsigned lsbs,
+                      unsigned shift,
+                      bool bmi2)
+{
+  std::size_t i = 0;
+  uint64_t bits = 0;
+#if defined(__x86_64__)
+  if (bmi2) {
+    i = n - n % (sizeof(uint64_t) / sizeof(T));
+    bits = extract_lsbs_bmi2(in, i, lsbs, shift);
+  }
+#else
+  (void)bmi2;
+#endif
+  if (i < n)
+    bits |= extract_lsbs_scalar(in + i, n - i, lsbs, shift) << (i * lsbs);
+  return bits;
+}
+
+template void deposit_lsbs(const int16_t*,
+                           int16_t*,
+                           std::size_t,
+                           uint64_t,
+                           unsigned,
+                           unsigned);
+template void deposit_lsbs(const int16_t*,
+                           int16_t*,
+                           std::size_t,
+                           uint64_t,
+                           unsigned,
+                           unsigned,
+                           bool);
+template uint64_t extract_lsbs(const int16_t*,
+                               std::size_t,
+                               unsigned,
+                               unsigned);
+template uint64_t extract_lsbs(const int16_t*,
+                               std::size_t,
+                               unsigned,
+                               unsigned,
+                               bool);
+
+template void deposit_lsbs(const int32_t*,
+                           int32_t*,
+                           std::size_t,
+                           uint64_t,
+                           unsigned,
+                           unsigned);
+template void deposit_lsbs(const int32_t*,
+                           int32_t*,
+                           std::size_t,
+                           uint64_t,
+                           unsigned,
+                           unsigned,
+                           bool);
+template uint64_t extract_lsbs(const int32_t*,
+                               std::size_t,
+                               unsigned,
+                               unsigned);
+template uint64_t extract_lsbs(const int32_t*,
+                               std::size_t,
+                               unsigned,
+                               unsigned,
+                               bool);
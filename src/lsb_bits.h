@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file lsb_bits.h
+ * @brief Substitution of the LSBs of consecutive samples with a word of bits.
+ *
+ * The kernels deposit and extract the bits of all samples whose LSBs fit a
+ * 64-bit word at once, with the BMI2 instructions pdep and pext on CPUs with
+ * fast ones, otherwise with portable loops.
+ */
+#ifndef LSB_BITS_H
+#define LSB_BITS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Whether the BMI2 kernels are used, the CPU has fast pdep and pext.
+ * Detected once.
+ */
+bool lsb_bmi2();
+
+/**
+ * @brief Get the number of samples whose LSBs make a word of bits.
+ *
+ * The count is a multiple of the samples in 64 bits if possible, so that the
+ * kernels process whole 64-bit words of samples.
+ * @param lsbs The number of LSBs of each sample, less than its width.
+ */
+template <typename T>
+std::size_t lsb_word_samples(unsigned lsbs)
+{
+  const std::size_t lanes = sizeof(uint64_t) / sizeof(T);
+  const std::size_t words = 64 / (lanes * lsbs);
+  return words > 0 ? words * lanes : 64 / lsbs;
+}
+
+/**
+ * Substitute the LSBs of samples with a word of bits.
+ *
+ * The bit above the LSBs and the padding bits below them are cleared.
+ * @param in The samples.
+ * @param out The buffer for the substituted samples, may be the same as in.
+ * @param n The number of samples, at most 64 / lsbs.
+ * @param bits The bits, the LSBs of the first sample the least significant.
+ * @param lsbs The number of LSBs of each sample.
+ * @param shift The number of the padding bits below the LSBs.
+ */
+template <typename T>
+void deposit_lsbs(const T* in,
+                  T* out,
+                  std::size_t n,
+                  uint64_t bits,
+                  unsigned lsbs,
+                  unsigned shift);
+
+/**
+ * Substitute with or without the BMI2 kernels, see deposit_lsbs(). The CPU
+ * has to support BMI2 if they are used.
+ */
+template <typename T>
+void deposit_lsbs(const T* in,
+                  T* out,
+                  std::size_t n,
+                  uint64_t bits,
+                  unsigned lsbs,
+                  unsigned shift,
+                  bool bmi2);
+
+/**
+ * Retrieve the LSBs of samples as a word of bits, see deposit_lsbs().
+ * @return The bits, the LSBs of the first sample the least significant.
+ */
+template <typename T>
+uint64_t extract_lsbs(const T* in,
+                      std::size_t n,
+                      unsigned lsbs,
+                      unsigned shift);
+
+/**
+ * Retrieve with or without the BMI2 kernels, see extract_lsbs(). The CPU has
+ * to support BMI2 if they are used.
+ */
+template <typename T>
+uint64_t extract_lsbs(const T* in,
+                      std::size_t n,
+                      unsigned lsbs,
+                      unsigned shift,
+                      bool bmi2);
+
+#endif  // LSB_BITS_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// the BMI2 kernels of lsb_bits.cpp, the samples are processed as 64-bit words
+// of 4 int16_t or 2 int32_t, pdep spreads the bits to the LSBs of all of them
+// and pext gathers them back
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Replicate a value of a sample to every sample of a 64-bit word.
+ */
+template <typename T>
+static uint64_t broadcast(uint64_t v)
+{
+  // 0x0001000100010001 for int16_t, 0x0000000100000001 for int32_t
+  return v * (~(uint64_t)0 / (~(uint64_t)0 >> (64 - 8 * sizeof(T))));
+}
+
+template <typename T>
+void deposit_lsbs_bmi2(const T* in,
+                       T* out,
+                       std::size_t n,
+                       uint64_t bits,
+                       unsigned lsbs,
+                       unsigned shift)
+{
+  const std::size_t lanes = sizeof(uint64_t) / sizeof(T);
+  const uint64_t mask = broadcast<T>((((uint64_t)1 << lsbs) - 1) << shift);
+  const uint64_t keep = ~broadcast<T>(((uint64_t)2 << (lsbs + shift)) - 1);
+  for (std::size_t i = 0; i < n; i += lanes) {
+    uint64_t word;
+    std::memcpy(&word, in + i, sizeof(word));
+    word = (word & keep) | _pdep_u64(bits >> (i * lsbs), mask);
+    std::memcpy(out + i, &word, sizeof(word));
+  }
+}
+
+template <typename T>
+uint64_t extract_lsbs_bmi2(const T* in,
+                           std::size_t n,
+                           unsigned lsbs,
+                           unsigned shift)
+{
+  const std::size_t lanes = sizeof(uint64_t) / sizeof(T);
+  const uint64_t mask = broadcast<T>((((uint64_t)1 << lsbs) - 1) << shift);
+  uint64_t bits = 0;
+  for (std::size_t i = 0; i < n; i += lanes) {
+    uint64_t word;
+    std::memcpy(&word, in + i, sizeof(word));
+    bits |= _pext_u64(word, mask) << (i * lsbs);
+  }
+  return bits;
+}
+
+template void deposit_lsbs_bmi2(const int16_t*,
+                                int16_t*,
+                                std::size_t,
+                                uint64_t,
+                                unsigned,
+                                unsigned);
+template uint64_t extract_lsbs_bmi2(const int16_t*,
+                                    std::size_t,
+                                    unsigned,
+                                    unsigned);
+
+template void deposit_lsbs_bmi2(const int32_t*,
+                                int32_t*,
+                                std::size_t,
+                                uint64_t,
+                                unsigned,
+                                unsigned);
+template uint64_t extract_lsbs_bmi2(const int32_t*,
+                                    std::size_t,
+                                    unsigned,
+                                    unsigned);
@@ -27,21 +27,39 @@ LSBMethod::LSBMethod(const Params& params)
   bit_depth = params.get_or("bit_depth", 16);
   if (bit_depth == -1)
     throw std::invalid_argument("lsb method works only with integer samples");
+  if (bits_per_frame >= (unsigned)bit_depth)
+    throw std::invalid_argument("number of LSBs must be < the bit depth");
 }
 
 embedder_variant LSBMethod::make_embedder(InBitStream& input) const
 {
-  return std::make_unique<LsbEmbedder<int>>(input, bits_per_frame,
-                                                     bit_depth);
+  if (bit_depth <= 16)
+    return std::make_unique<LsbEmbedder<int16_t>>(input, bits_per_frame,
+                                                  shift<int16_t>());
+  return std::make_unique<LsbEmbedder<int32_t>>(input, bits_per_frame,
+                                                shift<int32_t>());
 }
 
 extractor_variant LSBMethod::make_extractor() const
 {
-  return std::make_unique<LSBExtractor<int>>(bits_per_frame,
-                                                      bit_depth);
+  if (bit_depth <= 16)
+    return std::make_unique<LSBExtractor<int16_t>>(bits_per_frame,
+                                                   shift<int16_t>());
+  return std::make_unique<LSBExtractor<int32_t>>(bits_per_frame,
+                                                 shift<int32_t>());
 }
 
 ssize_t LSBMethod::capacity(std::size_t samples) const
 {
   return samples * bits_per_frame;
 }
+
+ssize_t LSBMethod::frame_bits() const
+{
+  return DEF_FRAME_SIZE * bits_per_frame;
+}
+
+bool LSBMethod::independent_extraction() const
+{
+  return true;
+}
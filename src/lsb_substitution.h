@@ -21,22 +21,47 @@
 #ifndef LSB_EMBEDDER_H
 #define LSB_EMBEDDER_H
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 #include "embedder.h"
 #include "extractor.h"
+#include "lsb_bits.h"
 #include "methods.h"
 
 #define BIT_WIDTH 16
 
+/**
+ * @brief The LSB substitution method.
+ *
+ * The samples are processed as int16_t for subformats of at most 16 bits, e.g.
+ * PCM_16, otherwise as int32_t, so that 16-bit files are read without
+ * conversion. The bits are embedded and extracted a 64-bit word at a time, see
+ * lsb_bits.h.
+ */
 class LSBMethod : public Method {
  public:
   LSBMethod(const Params& params);
   embedder_variant make_embedder(InBitStream& input) const override;
   extractor_variant make_extractor() const override;
   virtual ssize_t capacity(std::size_t samples) const override;
+  virtual ssize_t frame_bits() const override;
+  virtual bool independent_extraction() const override;
 
  protected:
+  /**
+   * @brief Get the number of the padding bits of the samples of the type.
+   *
+   * libsndfile scales the samples to the full range of the type, the LSBs of
+   * the subformat are above the padding.
+   */
+  template <typename T>
+  unsigned shift() const
+  {
+    return 8 * sizeof(T) - bit_depth;
+  }
+
   int bit_depth;
   unsigned bits_per_frame;
 };
@@ -44,66 +69,102 @@ class LSBMethod : public Method {
 template <class T>
 class LsbEmbedder : public Embedder<T> {
  public:
-  LsbEmbedder(InBitStream& data, unsigned bits_per_frame, unsigned bit_depth)
-      : Embedder<T>(data), bits_per_frame(bits_per_frame), bit_depth(bit_depth)
+  /**
+   * @brief Constructor.
+   * @param data The associated input bit stream.
+   * @param bits_per_frame The number of LSBs substituted in each sample.
+   * @param shift The number of the padding bits of the samples, below the
+   * LSBs of the file's subformat.
+   */
+  LsbEmbedder(InBitStream& data, unsigned bits_per_frame, unsigned shift)
+      : Embedder<T>(data), bits_per_frame(bits_per_frame), shift(shift)
   {
   }
 
   bool embed() override
   {
-    for (std::size_t i = 0; i < this->in_frame.size(); i++) {
-      typename std::make_unsigned<T>::type sample = this->in_frame[i];
-
-      sample = sample >> bit_depth;
+    return embed_samples(this->in_frame.data(), this->out_frame.data(),
+                         this->in_frame.size());
+  }
 
-      // make room for embedded bits
-      sample &= ((unsigned)~1 << bits_per_frame);
+  bool embed_frames(const PlanarBlock<T>& block) override
+  {
+    // the frames are consecutive, so the whole block is embedded at once, in
+    // place
+    return embed_samples(block.data(), block.data(), block.size());
+  }
 
-      for (unsigned j = 0; j < bits_per_frame; j++) {
-        int bit = this->data.next_bit();
-        if (bit == EOF) {
-          return true;
-        }
-        sample |= (unsigned)bit << j;
+ private:
+  bool embed_samples(const T* in, T* out, std::size_t n)
+  {
+    const std::size_t step = lsb_word_samples<T>(bits_per_frame);
+    for (std::size_t i = 0; i < n; i += step) {
+      const std::size_t count = std::min(step, n - i);
+      const unsigned wanted = count * bits_per_frame;
+      uint64_t bits;
+      const unsigned got = this->data.next_bits(bits, wanted);
+      if (got < wanted) {
+        // keep the bits embedded so far, pass the rest of the frame through
+        const std::size_t embedded =
+            (got + bits_per_frame - 1) / bits_per_frame;
+        deposit_lsbs(in + i, out + i, embedded, bits, bits_per_frame, shift);
+        if (in != out)
+          std::copy(in + i + embedded, in + n, out + i + embedded);
+        return true;
       }
-
-      this->out_frame[i] = sample << bit_depth;
+      deposit_lsbs(in + i, out + i, count, bits, bits_per_frame, shift);
     }
     return false;
   }
 
- private:
   unsigned bits_per_frame;
-  unsigned bit_depth;
+  unsigned shift;
 };
 
 template <typename T>
 class LSBExtractor : public Extractor<T> {
  public:
-  LSBExtractor(unsigned bits_per_frame, unsigned bit_depth)
-      : Extractor<T>(), bits_per_frame(bits_per_frame), bit_depth(bit_depth)
+  /**
+   * @brief Constructor.
+   * @param bits_per_frame The number of LSBs substituted in each sample.
+   * @param shift The number of the padding bits of the samples, see
+   * LsbEmbedder.
+   */
+  LSBExtractor(unsigned bits_per_frame, unsigned shift)
+      : Extractor<T>(), bits_per_frame(bits_per_frame), shift(shift)
   {
   }
 
   bool extract(OutBitStream& data) override
   {
-    for (std::size_t i = 0; i < this->in_frame.size(); i++) {
-      typename std::make_unsigned<T>::type sample = this->in_frame[i];
-
-      sample = sample >> bit_depth;
+    extract_samples(this->in_frame.data(), this->in_frame.size(), data);
+    return true;
+  }
 
-      for (unsigned j = 0; j < bits_per_frame; j++) {
-        bool bit = sample & ((unsigned)1 << j);
-        // std::cerr <<  bit;
-        data.output_bit(bit);
-      }
+  bool extract_frames(const PlanarBlock<const T>& block,
+                      OutBitStream& data) override
+  {
+    for (std::size_t i = 0; i < block.count(); i++) {
+      if (data.eof())
+        return false;
+      extract_samples(block.frame(i), this->_frame_size, data);
     }
     return true;
   }
 
  private:
+  void extract_samples(const T* in, std::size_t n, OutBitStream& data)
+  {
+    const std::size_t step = lsb_word_samples<T>(bits_per_frame);
+    for (std::size_t i = 0; i < n; i += step) {
+      const std::size_t count = std::min(step, n - i);
+      data.output_bits(extract_lsbs(in + i, count, bits_per_frame, shift),
+                       count * bits_per_frame);
+    }
+  }
+
   unsigned bits_per_frame;
-  unsigned bit_depth;
+  unsigned shift;
 };
 
 #endif
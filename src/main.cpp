@@ -14,11 +14,18 @@
  * You should have received a copy of the GNU General Public License along with
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -34,7 +41,15 @@
 #include "method_factory.h"
 #include "methods.h"
 #include "obitstream.h"
+#include "planner.h"
 #include "stegofile.h"
+#include "thread_pool.h"
+
+// the audio parameters the plan command creates the methods for
+#define PLAN_SAMPLERATE 44100
+#define PLAN_BIT_DEPTH 16
+// the plan command plans the blocks of files with up to this many channels
+#define PLAN_CHANNELS 2
 
 void print_fileinfo(SndfileHandle& file,
                     const std::string& filename,
@@ -84,9 +99,13 @@ void print_help()
   std::cout << "Usage: "
                "stego embed -m method -cf coverfile -sf stegofile [-mf "
                "messagefile] [-k key] [-e] [-l limit]\n"
+               "             [-pc|-pp|-j jobs] [-b frames] [-P rigor] [-w wisdom]\n"
                "       stego extract -m method -sf stegofile [-mf messagefile] "
                "[-k key] [-e] [-l limit]\n"
+               "             [-pc|-pp|-j jobs] [-b frames] [-P rigor] [-w wisdom]\n"
                "       stego info <filename> [-k key]\n"
+               "       stego batch <manifest> [-j jobs] [-P rigor] [-w wisdom]\n"
+               "       stego plan [-k key] [-b frames] [-P rigor] [-w wisdom]\n"
                "\n"
                "Options:\n"
                "       -cf   The cover file\n"
@@ -103,8 +122,37 @@ void print_help()
   std::cout << "       -k    The stego key (method parameter)\n"
                "       -e    Use Hamming code for the message\n"
                "       -l    Message length limit\n"
+               "       -pc   Process the channels in parallel, the message\n"
+               "             is distributed among the channels\n"
+               "       -pp   Decode, process and encode the audio on separate\n"
+               "             threads\n"
+               "       -j    Process segments of the file on the given number\n"
+               "             of threads, embedding only for lsb, tone and echo,\n"
+               "             extraction also for echo and echo-hc\n"
+               "       -b    The number of frames processed at once, by default\n"
+               "             8, not with -pc or -j\n"
+               "       -P    The FFT planner rigor, one of: estimate (default),\n"
+               "             measure, patient, exhaustive\n"
+               "       -w    The FFTW wisdom file, by default $STEGO_WISDOM or\n"
+               "             stego/wisdom in the cache directory\n"
+               "\n"
+               "The wisdom is loaded on start and saved on exit when the plans\n"
+               "were measured. The plan command measures the plans of all\n"
+               "methods for the given key, by default with -P measure, for\n"
+               "files with up to 2 channels and the block size given by -b,\n"
+               "by default 8.\n"
+               "\n"
+               "Batch manifest: one embed or extract command per line, with the\n"
+               "same arguments as above, -mf is required. Arguments containing\n"
+               "whitespace are enclosed in double quotes, with \\\" and \\\\ for\n"
+               "a quote and a backslash. Empty lines and lines starting with #\n"
+               "are skipped. The jobs run on -j threads, by default one per CPU.\n"
+               "The planner is set for the whole batch, the jobs can't have -P, -w\n"
+               "or the planner key.\n"
                "\n"
                "Stego key format: key=value\n"
+               "Common stego keys:\n"
+               "            planner    - The FFT planner rigor, same as -P\n"
                "Method stego keys:\n";
   for (const auto& method : methods) {
     std::cout << setw(10) << left << method << ": ";
@@ -127,43 +175,162 @@ void print_help()
                "it. There is NO WARRANTY, to the extent permitted by law.\n";
 }
 
-bool embed_command(const struct args& args)
+/**
+ * @brief A function providing a method with the given name and parameters.
+ */
+using MethodProvider = std::function<std::shared_ptr<const Method>(
+    const std::string& name,
+    const Params& params)>;
+
+/**
+ * @brief Create a new method with the given name and parameters.
+ */
+std::shared_ptr<const Method> create_method(const std::string& name,
+                                            const Params& params)
+{
+  return MethodFactory::create(name, params);
+}
+
+/**
+ * @brief Methods shared by batch jobs with the same parameters.
+ */
+class MethodCache {
+ public:
+  /**
+   * @brief Get the method with the given name and parameters.
+   * The method is created on the first request, the later requests with the
+   * same name and parameters get the same method.
+   */
+  std::shared_ptr<const Method> get(const std::string& name,
+                                    const Params& params)
+  {
+    const std::string key = name + ':' + params.to_string();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = methods.find(key);
+    if (it != methods.end())
+      return it->second;
+
+    std::shared_ptr<const Method> method = create_method(name, params);
+    methods[key] = method;
+    return method;
+  }
+
+ private:
+  std::mutex mutex;
+  std::map<std::string, std::shared_ptr<const Method>> methods;
+};
+
+/**
+ * @brief Call the function with a factory of embedders of the method.
+ * The factory takes the input bit stream and returns a unique_ptr to the
+ * embedder of the method's sample type.
+ */
+template <typename F>
+void with_embedder_factory(const Method& method, F f)
+{
+  // only determines the sample type, the bits are never read
+  VectorInBitStream empty{BitVector()};
+  std::visit(
+      [&](auto&& v) {
+        using E = typename std::decay_t<decltype(v)>::element_type;
+        f([&](InBitStream& in) {
+          return std::get<std::unique_ptr<E>>(method.make_embedder(in));
+        });
+      },
+      method.make_embedder(empty));
+}
+
+/**
+ * @brief Call the function with a factory of extractors of the method.
+ * The factory returns a unique_ptr to the extractor of the method's sample
+ * type.
+ */
+template <typename F>
+void with_extractor_factory(const Method& method, F f)
+{
+  std::visit(
+      [&](auto&& v) {
+        using E = typename std::decay_t<decltype(v)>::element_type;
+        f([&]() {
+          return std::get<std::unique_ptr<E>>(method.make_extractor());
+        });
+      },
+      method.make_extractor());
+}
+
+/**
+ * @brief Embed the message as given by the program arguments.
+ * @param args The arguments of the embed command.
+ * @param make_method A function providing the method for the parameters.
+ */
+void embed(const struct args& args, const MethodProvider& make_method)
 {
   std::shared_ptr<istream> input;
   if (args.msgfile) {
     ifstream* file = new ifstream(args.msgfile.value());
     if (!file->is_open()) {
-      std::cerr << "Unable to open file " << args.msgfile.value() << std::endl;
-      return 0;
+      delete file;
+      throw IOException("Unable to open file " + args.msgfile.value());
     }
     input.reset(file);
   } else {
     input.reset(&std::cin, [](...) {});
   }
 
-  try {
-    CoverFile coverfile{args.coverfile.value()};
+  CoverFile coverfile{args.coverfile.value()};
 
-    Params params = parse_key(args.key);
-    params.insert("samplerate",
-                  std::to_string(coverfile.audio_params().samplerate));
-    params.insert("bit_depth",
-                  std::to_string(coverfile.audio_params().bit_depth));
+  Params params = parse_key(args.key);
+  params.insert("samplerate",
+                std::to_string(coverfile.audio_params().samplerate));
+  params.insert("bit_depth",
+                std::to_string(coverfile.audio_params().bit_depth));
 
-    auto method = MethodFactory::create(args.method.value(), params);
+  std::shared_ptr<const Method> method =
+      make_method(args.method.value(), params);
 
-    std::shared_ptr<InBitStream> wrapper = InBitStream::from_istream(*input);
-    if (args.limit)
-      wrapper = make_shared<LimitedInBitStream>(wrapper, args.limit.value());
-    if (args.use_err_correction)
-      wrapper = make_shared<HammingInBitStream>(wrapper);
+  std::shared_ptr<InBitStream> wrapper = InBitStream::from_istream(*input);
+  if (args.limit)
+    wrapper = make_shared<LimitedInBitStream>(wrapper, args.limit.value());
+  if (args.use_err_correction)
+    wrapper = make_shared<HammingInBitStream>(wrapper);
 
+  if (args.parallel_channels) {
+    with_embedder_factory(*method, [&](auto make_embedder) {
+      coverfile.embed_channels(args.stegofile.value(), make_embedder,
+                               *wrapper);
+    });
+  } else if (args.jobs) {
+    if (method->frame_bits() < 0)
+      throw std::invalid_argument("method " + args.method.value() +
+                                  " can't embed segments in parallel");
+
+    with_embedder_factory(*method, [&](auto make_embedder) {
+      coverfile.embed_segments(args.stegofile.value(), make_embedder,
+                               *wrapper, method->frame_bits(),
+                               method->embed_warmup(), args.jobs.value());
+    });
+  } else if (args.pipelined) {
     std::visit(
         [&](auto&& v) {
-          coverfile.embed(args.stegofile.value(), *v, *wrapper);
+          coverfile.embed_pipelined(
+              args.stegofile.value(), *v,
+              args.block_size.value_or(PIPELINE_BLOCK_FRAMES));
         },
         method->make_embedder(*wrapper));
+  } else {
+    std::visit(
+        [&](auto&& v) {
+          coverfile.embed(args.stegofile.value(), *v, *wrapper,
+                          args.block_size.value_or(DEF_BLOCK_FRAMES));
+        },
+        method->make_embedder(*wrapper));
+  }
+}
 
+bool embed_command(const struct args& args)
+{
+  try {
+    embed(args, create_method);
   } catch (const std::invalid_argument& e) {
     std::cerr << "Error: " << e.what() << std::endl;
     return 0;
@@ -174,39 +341,75 @@ bool embed_command(const struct args& args)
   return 1;
 }
 
-bool extract_command(const struct args& args)
+/**
+ * @brief Extract the message as given by the program arguments.
+ * @param args The arguments of the extract command.
+ * @param make_method A function providing the method for the parameters.
+ */
+void extract(const struct args& args, const MethodProvider& make_method)
 {
   std::shared_ptr<ostream> output;
   if (args.msgfile) {
     ofstream* file = new ofstream(args.msgfile.value());
     if (!file->is_open()) {
-      std::cerr << "Unable to open file " << args.msgfile.value() << std::endl;
-      return 0;
+      delete file;
+      throw IOException("Unable to open file " + args.msgfile.value());
     }
     output.reset(file);
   } else {
     output.reset(&std::cout, [](...) {});
   }
 
-  try {
-    StegoFile stegofile{args.stegofile.value()};
+  StegoFile stegofile{args.stegofile.value()};
 
-    Params params = parse_key(args.key);
-    params.insert("samplerate",
-                  std::to_string(stegofile.audio_params().samplerate));
-    params.insert("bit_depth",
-                  std::to_string(stegofile.audio_params().bit_depth));
+  Params params = parse_key(args.key);
+  params.insert("samplerate",
+                std::to_string(stegofile.audio_params().samplerate));
+  params.insert("bit_depth",
+                std::to_string(stegofile.audio_params().bit_depth));
+
+  std::shared_ptr<const Method> method =
+      make_method(args.method.value(), params);
+  std::shared_ptr<OutBitStream> wrapped = OutBitStream::to_ostream(*output);
+  if (args.limit)
+    wrapped = make_shared<LimitedOutBitStream>(wrapped, args.limit.value());
+  if (args.use_err_correction)
+    wrapped = make_shared<HammingOutBitStream>(wrapped);
 
-    auto method = MethodFactory::create(args.method.value(), params);
-    std::shared_ptr<OutBitStream> wrapped = OutBitStream::to_ostream(*output);
-    if (args.limit)
-      wrapped = make_shared<LimitedOutBitStream>(wrapped, args.limit.value());
-    if (args.use_err_correction)
-      wrapped = make_shared<HammingOutBitStream>(wrapped);
+  if (args.parallel_channels) {
+    with_extractor_factory(*method, [&](auto make_extractor) {
+      stegofile.extract_channels(make_extractor, *wrapped);
+    });
+  } else if (args.jobs) {
+    if (!method->independent_extraction())
+      throw std::invalid_argument("method " + args.method.value() +
+                                  " can't extract segments in parallel");
 
-    std::visit([&](auto&& v) { stegofile.extract(*v, *wrapped); },
-               method->make_extractor());
+    with_extractor_factory(*method, [&](auto make_extractor) {
+      stegofile.extract_segments(make_extractor, *wrapped,
+                                 args.jobs.value());
+    });
+  } else if (args.pipelined) {
+    std::visit(
+        [&](auto&& v) {
+          stegofile.extract_pipelined(
+              *v, *wrapped, args.block_size.value_or(PIPELINE_BLOCK_FRAMES));
+        },
+        method->make_extractor());
+  } else {
+    std::visit(
+        [&](auto&& v) {
+          stegofile.extract(*v, *wrapped,
+                            args.block_size.value_or(DEF_BLOCK_FRAMES));
+        },
+        method->make_extractor());
+  }
+}
 
+bool extract_command(const struct args& args)
+{
+  try {
+    extract(args, create_method);
   } catch (const std::invalid_argument& e) {
     std::cerr << "Error: " << e.what() << std::endl;
     return 0;
@@ -217,6 +420,234 @@ bool extract_command(const struct args& args)
   return 1;
 }
 
+/**
+ * @brief The result of a batch job.
+ */
+struct JobResult {
+  unsigned line;
+  bool ok = false;
+  std::string error;
+};
+
+/**
+ * @brief Run a batch job, a line of the manifest.
+ * @param line The manifest line, the arguments of an embed or extract command.
+ * @param methods The methods shared by the jobs.
+ * @param result The result of the job.
+ */
+void run_job(const std::string& line, MethodCache& methods, JobResult& result)
+{
+  try {
+    std::vector<std::string> tokens{"stego"};
+    std::istringstream ss{line};
+    std::string token;
+    // the arguments with whitespace are quoted, e.g. -mf "my message.txt"
+    while (ss >> std::quoted(token)) {
+      tokens.push_back(token);
+    }
+    std::vector<char*> argv;
+    for (std::string& t : tokens) {
+      argv.push_back(t.data());
+    }
+
+    struct args args = parse_args(argv.size(), argv.data());
+    if (args.command != "embed" && args.command != "extract")
+      throw std::invalid_argument("only embed and extract jobs are allowed");
+    if (!args.msgfile)
+      throw std::invalid_argument("batch jobs require a message file (-mf)");
+    // the planner is shared by all jobs running at the same time
+    if (args.planner || args.wisdom || parse_key(args.key).count("planner"))
+      throw std::invalid_argument(
+          "-P, -w and the planner key are only allowed for the whole batch");
+
+    auto provider = [&](const std::string& name, const Params& params) {
+      return methods.get(name, params);
+    };
+    if (args.command == "embed")
+      embed(args, provider);
+    else
+      extract(args, provider);
+    result.ok = true;
+  } catch (const std::exception& e) {
+    result.error = e.what();
+  }
+  // the messages may end with a newline
+  result.error.erase(result.error.find_last_not_of(" \n") + 1);
+}
+
+bool batch_command(const struct args& args)
+{
+  std::ifstream manifest{args.manifest.value()};
+  if (!manifest.is_open()) {
+    std::cerr << "Unable to open file " << args.manifest.value() << std::endl;
+    return 0;
+  }
+
+  std::vector<std::string> lines;
+  std::vector<JobResult> results;
+  std::string line;
+  for (unsigned n = 1; std::getline(manifest, line); n++) {
+    std::size_t start = line.find_first_not_of(" \t\r");
+    // skip empty lines and comments
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+    lines.push_back(line);
+    results.push_back(JobResult{n, false, ""});
+  }
+
+  MethodCache methods;
+  {
+    unsigned threads = args.jobs.value_or(std::thread::hardware_concurrency());
+    ThreadPool pool{std::max(threads, 1u)};
+    for (std::size_t i = 0; i < lines.size(); i++) {
+      pool.submit([&, i] { run_job(lines[i], methods, results[i]); });
+    }
+    pool.wait();
+  }
+
+  unsigned failed = 0;
+  for (const JobResult& result : results) {
+    std::cout << args.manifest.value() << ':' << result.line << ": ";
+    if (result.ok) {
+      std::cout << "ok\n";
+    } else {
+      std::cout << "failed: " << result.error << '\n';
+      failed++;
+    }
+  }
+  std::cout << results.size() - failed << " of " << results.size()
+            << " jobs succeeded" << std::endl;
+  return failed == 0;
+}
+
+/**
+ * @brief Embed into a silent block of frames, which creates the plans of the
+ * batched transforms of the embedder for the block.
+ */
+template <typename T>
+void plan_embed_frames(Embedder<T>& embedder,
+                       std::size_t block_size,
+                       unsigned channels)
+{
+  const std::size_t frame_size = embedder.frame_size();
+  aligned_vector<T> samples(block_size * channels * frame_size);
+  (void)embedder.embed_frames(
+      PlanarBlock<T>(samples.data(), block_size, channels, frame_size));
+}
+
+/**
+ * @brief Extract from a silent block of frames, which creates the plans of the
+ * batched transforms of the extractor for the block.
+ */
+template <typename T>
+void plan_extract_frames(Extractor<T>& extractor,
+                         std::size_t block_size,
+                         unsigned channels)
+{
+  const std::size_t frame_size = extractor.frame_size();
+  const aligned_vector<T> samples(block_size * channels * frame_size);
+  VectorOutBitStream output;
+  (void)extractor.extract_frames(
+      PlanarBlock<const T>(samples.data(), block_size, channels, frame_size),
+      output);
+}
+
+/**
+ * @brief Get the FFT planner rigor given by the arguments, the planner key
+ * takes precedence over -P.
+ * @return The rigor or an empty string if none is given.
+ */
+std::string planner_rigor(const struct args& args)
+{
+  const Params params = parse_key(args.key);
+  return params.get_or("planner", args.planner.value_or(std::string()));
+}
+
+bool plan_command(const struct args& args)
+{
+  if (planner_rigor(args).empty())
+    set_planner_rigor("measure");
+
+  // enough bits for the first frame of any method
+  const BitVector bits(DEF_FRAME_SIZE * 8);
+  // the block size given by -b, each block size needs its own plans, or the
+  // default ones of the serial and pipelined processing
+  std::vector<std::size_t> block_sizes{DEF_BLOCK_FRAMES};
+  if (args.block_size)
+    block_sizes = {args.block_size.value()};
+  else if (PIPELINE_BLOCK_FRAMES != DEF_BLOCK_FRAMES)
+    block_sizes.push_back(PIPELINE_BLOCK_FRAMES);
+
+  bool ok = true;
+  for (const auto& name : MethodFactory::list_methods()) {
+    try {
+      Params params = parse_key(args.key);
+      params.insert("samplerate", std::to_string(PLAN_SAMPLERATE));
+      params.insert("bit_depth", std::to_string(PLAN_BIT_DEPTH));
+      auto method = MethodFactory::create(name, params);
+
+      // the plans are created on the first run, of single frames for -pc
+      // and -j
+      VectorInBitStream input{bits};
+      std::visit([](auto&& v) { (void)v->embed(); },
+                 method->make_embedder(input));
+      VectorOutBitStream output;
+      std::visit([&](auto&& v) { (void)v->extract(output); },
+                 method->make_extractor());
+
+      // and of the blocks of all channels, by new embedders and extractors,
+      // which plan for the first block they get
+      for (std::size_t block_size : block_sizes) {
+        for (unsigned channels = 1; channels <= PLAN_CHANNELS; channels++) {
+          VectorInBitStream block_input{bits};
+          std::visit(
+              [&](auto&& v) { plan_embed_frames(*v, block_size, channels); },
+              method->make_embedder(block_input));
+          std::visit(
+              [&](auto&& v) { plan_extract_frames(*v, block_size, channels); },
+              method->make_extractor());
+        }
+      }
+      std::cout << "Planned " << name << std::endl;
+    } catch (const std::invalid_argument& e) {
+      std::cerr << "Error: " << name << ": " << e.what() << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+/**
+ * @brief Run the command with the FFT planner configured by the arguments.
+ * The planner is global, it is only configured here, before the command. The
+ * wisdom is loaded before the command and saved after it, if the plans were
+ * measured.
+ */
+bool with_planner(const struct args& args,
+                  bool (*command)(const struct args& args))
+{
+  try {
+    const std::string rigor = planner_rigor(args);
+    if (!rigor.empty())
+      set_planner_rigor(rigor);
+  } catch (const std::invalid_argument& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 0;
+  }
+
+  const std::string wisdom = args.wisdom.value_or(default_wisdom_file());
+  if (!wisdom.empty())
+    import_wisdom(wisdom);
+
+  bool ok = command(args);
+
+  if (!wisdom.empty() && planner_flags() != FFTW_ESTIMATE &&
+      !export_wisdom(wisdom))
+    std::cerr << "Warning: failed to save the FFTW wisdom to " << wisdom
+              << std::endl;
+  return ok;
+}
+
 bool info_command(struct args& args)
 {
   SndfileHandle file{args.coverfile.value(), SFM_READ};
@@ -253,10 +684,14 @@ int main(int argc, char* argv[])
     return !info_command(args);
   }
 
-  if (args.command == "embed") {
-    return !embed_command(args);
+  if (args.command == "batch") {
+    return !with_planner(args, batch_command);
+  } else if (args.command == "plan") {
+    return !with_planner(args, plan_command);
+  } else if (args.command == "embed") {
+    return !with_planner(args, embed_command);
   } else if (args.command == "extract") {
-    return !extract_command(args);
+    return !with_planner(args, extract_command);
   }
   // UNREACHABLE
   return EXIT_SUCCESS;
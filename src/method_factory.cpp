@@ -53,13 +53,17 @@ MethodFactory::creator_map MethodFactory::method_map = {
      Register{create_unique<LSBMethod>,
               {Param("lsbs", "number of lsbs in samples to substitute")}}},
     {"phase", Register{create_unique<PhaseMethod>,
-                       {Param("framesize", "the length of one audio frame")}}},
+                       {
+                           Param("framesize", "the length of one audio frame"),
+                           Param("precision", "DSP precision, double or float"),
+                       }}},
     {"echo", Register{create_unique<EchoHidingMethod>,
                       {
                           Param("delay0", "echo delay for bit 0"),
                           Param("delay1", "echo delay for bit 1"),
                           Param("amp", "echo amplitude (0-1)"),
                           Param("framesize", "the length of one audio frame"),
+                          Param("precision", "DSP precision, double or float"),
                       }}},
     {"echo-hc",
      Register{create_unique<EchoHidingHCMethod>,
@@ -67,12 +71,17 @@ MethodFactory::creator_map MethodFactory::method_map = {
                   Param("interval", "space between echo positions"),
                   Param("amp", "echo amplitude (0-1)"),
                   Param("framesize", "the length of one audio frame"),
+                  Param("precision", "DSP precision, double or float"),
               }}},
     {"tone", Register{create_unique<ToneInsertionMethod>,
                       {
                           Param("freq0", "the frequency for bit 0"),
                           Param("freq1", "the frequency for bit 1"),
+                          Param("carriers",
+                                "frequency pairs for bit 0 and 1 of several "
+                                "carriers, f0:f1/f0:f1/..."),
                           Param("framesize", "the length of one audio frame"),
+                          Param("precision", "DSP precision, double or float"),
                       }}}};
 
 std::unique_ptr<Method> MethodFactory::create(const std::string& method_name,
@@ -17,6 +17,7 @@
 #ifndef METHODS_H
 #define METHODS_H
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <stdexcept>
@@ -28,11 +29,24 @@
 #include "embedder.h"
 #include "extractor.h"
 
+/**
+ * @brief The embedders of any sample type.
+ *
+ * The files are read and written in the sample type of the embedder, libsndfile
+ * converts the samples of the file's subformat to it.
+ */
 using embedder_variant = std::variant<std::unique_ptr<Embedder<double>>,
-                                      std::unique_ptr<Embedder<int>>>;
+                                      std::unique_ptr<Embedder<float>>,
+                                      std::unique_ptr<Embedder<int32_t>>,
+                                      std::unique_ptr<Embedder<int16_t>>>;
 
+/**
+ * @brief The extractors of any sample type, see embedder_variant.
+ */
 using extractor_variant = std::variant<std::unique_ptr<Extractor<double>>,
-                                       std::unique_ptr<Extractor<int>>>;
+                                       std::unique_ptr<Extractor<float>>,
+                                       std::unique_ptr<Extractor<int32_t>>,
+                                       std::unique_ptr<Extractor<int16_t>>>;
 
 /**
  * @brief Method parameters with supplied values.
@@ -61,6 +75,22 @@ class Params {
    */
   void insert(std::string name, std::string value) { map[name] = value; }
 
+  /**
+   * @brief Get the parameters as a string sorted by the names.
+   * The string has the stego key format, equal parameters give equal strings.
+   */
+  std::string to_string() const
+  {
+    std::map<std::string, std::string> sorted{map.begin(), map.end()};
+    std::string str;
+    for (const auto& [key, value] : sorted) {
+      if (!str.empty())
+        str += ',';
+      str += key + '=' + value;
+    }
+    return str;
+  }
+
   /**
    * @brief Prints the contents to stderr.
    */
@@ -89,6 +119,7 @@ class Params {
   ACCESSOR_OR_DEF(unsigned, std::stoul);
   ACCESSOR_OR_DEF(unsigned long long, std::stoull);
   ACCESSOR_OR_DEF(double, std::stod);
+  ACCESSOR_OR_DEF(std::string, std::string);
 
 /**
  * @brief Define an accessor.
@@ -109,6 +140,23 @@ class Params {
   ACCESSOR_DEF(double, d, std::stod);
 };
 
+/**
+ * @brief Whether the parameters select the single precision.
+ *
+ * The frequency-domain methods take the precision parameter, either double
+ * (the default) or float.
+ * @throws std::invalid_argument If the precision is neither float nor double.
+ */
+inline bool single_precision(const Params& params)
+{
+  const std::string precision = params.get_or("precision", std::string());
+  if (precision.empty() || precision == "double")
+    return false;
+  if (precision == "float")
+    return true;
+  throw std::invalid_argument("precision must be float or double");
+}
+
 /**
  * @brief A steganographic method.
  */
@@ -116,16 +164,43 @@ class Method {
  public:
   /**
    * @brief Create an embedder for this method.
+   *
+   * The sample type of the embedder is the one the method prefers for the
+   * file's subformat, given by the bit_depth parameter, e.g. the narrowest
+   * integer type holding the samples.
    */
   virtual embedder_variant make_embedder(InBitStream& input) const = 0;
   /**
    * @brief Create an extractor for this method.
+   *
+   * The sample type is the same as the one of the embedder.
    */
   virtual extractor_variant make_extractor() const = 0;
   /**
    * @brief Get the capacity of this method for the given number of samples.
    */
   virtual ssize_t capacity(std::size_t samples) const = 0;
+  /**
+   * @brief Get the number of bits embedded into each frame of a channel.
+   *
+   * Only methods embedding a fixed number of bits into every frame report
+   * the number, these can embed segments of the file in parallel. Any state
+   * carried from one frame to the next is rebuilt by warming up the embedder
+   * for embed_warmup() frames.
+   * @return The number of bits, or -1 if it isn't fixed.
+   */
+  virtual ssize_t frame_bits() const { return -1; }
+  /**
+   * @brief Get the number of preceding frames an embedder has to process to
+   * reach the state it would have when embedding the whole file.
+   */
+  virtual std::size_t embed_warmup() const { return 0; }
+  /**
+   * @brief Whether the extractor decides each frame independently.
+   *
+   * Segments of the file can be extracted in parallel for such methods.
+   */
+  virtual bool independent_extraction() const { return false; }
 };
 
 #endif  // METHODS_H
@@ -17,7 +17,9 @@
 #ifndef OBITSTREAM_H
 #define OBITSTREAM_H
 
+#include <algorithm>
 #include <bitset>
+#include <cstdint>
 #include <memory>
 
 #include "bitvector.h"
@@ -34,6 +36,21 @@ class OutBitStream {
    */
   inline virtual void output_bit(bool bit) = 0;
 
+  /**
+   * @brief Put bits into the stream at once.
+   *
+   * The bits are put from the least significant one, the same as calling
+   * output_bit() for each of them.
+   * @param bits The bits to put to the stream.
+   * @param n The number of the bits, at most 64.
+   */
+  virtual void output_bits(uint64_t bits, unsigned n)
+  {
+    for (unsigned i = 0; i < n; i++) {
+      output_bit((bits >> i) & 1);
+    }
+  }
+
   /**
    * @brief Query the current EOF status.
    * Returns true if the stream is at the end, else false.
@@ -62,6 +79,22 @@ class OutBitStream {
           i = 0;
         }
       }
+      void output_bits(uint64_t bits, unsigned n)
+      {
+        // up to the rest of the current byte at once
+        while (n > 0 && !os.eof()) {
+          const unsigned take = std::min(n, 8u - i);
+          buff |= (bits & ((1u << take) - 1)) << i;
+          i += take;
+          bits >>= take;
+          n -= take;
+          if (i == 8) {
+            os.put(buff);
+            buff = 0;
+            i = 0;
+          }
+        }
+      }
 
      private:
       bool eof() const { return os.eof(); }
@@ -84,6 +117,11 @@ class VectorOutBitStream : public OutBitStream {
 
   inline virtual void output_bit(bool bit) override { sink.push_back(bit); }
 
+  void output_bits(uint64_t bits, unsigned n) override
+  {
+    sink.append(bits, static_cast<unsigned char>(n));
+  }
+
   bool eof() const override;
 
   BitVector to_vector() const;
@@ -108,6 +146,15 @@ class LimitedOutBitStream : public OutBitStream {
     }
   }
 
+  void output_bits(uint64_t bits, unsigned n) override
+  {
+    n = std::min<std::size_t>(n, limit - count);
+    if (n > 0) {
+      in->output_bits(bits, n);
+      count += n;
+    }
+  }
+
   virtual bool eof() const override;
 
  private:
@@ -14,7 +14,6 @@
  * You should have received a copy of the GNU General Public License along with
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
-#include <cassert>
 #include <string>
 #include <vector>
 
@@ -40,16 +39,24 @@ PhaseMethod::PhaseMethod(const Params& params)
     throw std::invalid_argument(
         "\"from\" frequency must be lower than \"to\" frequency");
   }
+
+  single = single_precision(params);
 };
 
 embedder_variant PhaseMethod::make_embedder(InBitStream& input) const
 {
-  return make_unique<PhaseEmbedder>(input, frame_size, bin_from, bin_to);
+  if (single)
+    return make_unique<PhaseEmbedder<float>>(input, frame_size, bin_from,
+                                             bin_to);
+  return make_unique<PhaseEmbedder<double>>(input, frame_size, bin_from,
+                                            bin_to);
 }
 
 extractor_variant PhaseMethod::make_extractor() const
 {
-  return make_unique<PhaseExtractor>(frame_size, bin_from, bin_to);
+  if (single)
+    return make_unique<PhaseExtractor<float>>(frame_size, bin_from, bin_to);
+  return make_unique<PhaseExtractor<double>>(frame_size, bin_from, bin_to);
 }
 
 ssize_t PhaseMethod::capacity([[maybe_unused]] std::size_t samples) const
@@ -57,48 +64,37 @@ ssize_t PhaseMethod::capacity([[maybe_unused]] std::size_t samples) const
   return bin_to - bin_from;
 }
 
-PhaseEmbedder::PhaseEmbedder(InBitStream& data,
-                             std::size_t frame_size,
-                             std::size_t bin_from,
-                             std::size_t bin_to)
-    : Embedder(data, frame_size),
+template <typename T>
+PhaseEmbedder<T>::PhaseEmbedder(InBitStream& data,
+                                std::size_t frame_size,
+                                std::size_t bin_from,
+                                std::size_t bin_to)
+    : Embedder<T>(data, frame_size),
       bin_from(bin_from),
       bin_to(bin_to),
-      amps_curr(in_frame.size()),
-      phases_prev(in_frame.size()),
-      phases_curr(in_frame.size()),
-      backup(in_frame.size()),
-      diff_curr(in_frame.size()),
-      dft(in_frame.size()),
-      fft(in_frame.size(), in_frame, dft),
-      ifft(in_frame.size(), dft, out_frame)
+      amps_curr(this->in_frame.size()),
+      phases_curr(this->in_frame.size()),
+      rotor(this->in_frame.size()),
+      dft(this->in_frame.size()),
+      fft(this->in_frame.size(), this->in_frame, dft),
+      ifft(this->in_frame.size(), dft, this->out_frame),
+      batch(frame_size, frame_size, frame_size, true)
 {
 }
 
-static void diff(std::vector<double>& a,
-                 std::vector<double>& b,
-                 std::vector<double>& diff)
-{
-  assert(a.size() == b.size());
-  assert(diff.size() == b.size());
-
-  for (unsigned i = 0; i < a.size(); i++) {
-    diff[i] = a[i] - b[i];
-  }
-}
-
 /**
  * Encodes data into the initial phases of signal
  *
  * @param phases The phases to embed into
  * @return The number of phases modified beginning at START
  */
-std::size_t PhaseEmbedder::encodeFirstBlock(vector<double>& phases)
+template <typename T>
+std::size_t PhaseEmbedder<T>::encodeFirstBlock(aligned_vector<T>& phases)
 {
   std::size_t i = 0;
 
 #if 0
-  std::vector<double> encoded;
+  aligned_vector<T> encoded;
   int bit;
   while ((bit = data.next_bit()) != EOF && i < (fft_len - 1)) {
     encoded.push_back(bit ? (M_PI_2) : -(M_PI_2));
@@ -111,7 +107,7 @@ std::size_t PhaseEmbedder::encodeFirstBlock(vector<double>& phases)
   }
 #else
   for (i = bin_from; i < bin_to; i++) {
-    int bit = data.next_bit();
+    int bit = this->data.next_bit();
     if (bit == EOF)
       break;
 
@@ -144,60 +140,103 @@ std::size_t PhaseEmbedder::encodeFirstBlock(vector<double>& phases)
   return i - bin_from;
 }
 
-bool PhaseEmbedder::embed()
+template <typename T>
+bool PhaseEmbedder<T>::embed()
 {
   fft.exec();
-  amplitude(dft, amps_curr, frame_size());
-  angle(dft, phases_curr, frame_size());
+  modulate(dft.data());
+  ifft.exec();
+
+  // all blocks need to be modified (phase shifted)
+  return false;
+}
+
+template <typename T>
+bool PhaseEmbedder<T>::embed_frames(const PlanarBlock<T>& block)
+{
+  const unsigned count = block.count();
+
+  batch.forward(block.data(), count);
+  for (unsigned i = 0; i < count; i++) {
+    modulate(batch.spectrum(i));
+  }
+  batch.inverse(block.data(), count);
+
+  return false;
+}
 
+template <typename T>
+void PhaseEmbedder<T>::modulate(std::complex<T>* dft)
+{
   if (frame == 0) {
-    backup = phases_curr;
+    amplitude(dft, amps_curr.data(), this->frame_size());
+    angle(dft, phases_curr.data(), this->frame_size());
+
+    const aligned_vector<T> phases_orig = phases_curr;
     // save the number of actually modified phases - only those actually need to
     // be shifted
     encoded = encodeFirstBlock(phases_curr);
-    // save for the next frame
-    std::copy(phases_curr.begin(), phases_curr.end(), phases_prev.begin());
+
+    // All the following frames are shifted by the same phase difference to
+    // preserve the relative phases between frames, save it as complex rotors.
+    for (std::size_t i = 0; i < rotor.size(); i++) {
+      rotor[i] = std::polar<T>(1, phases_curr[i] - phases_orig[i]);
+    }
+
+    polar_to_cartesian(dft, amps_curr.data(), phases_curr.data(),
+                       this->frame_size());
   } else {
-    diff(phases_curr, backup, diff_curr);
-    backup = phases_curr;
     for (std::size_t i = bin_from; i < encoded; i += 1) {
-      phases_curr[i] = phases_prev[i] + diff_curr[i];
+      dft[i] *= rotor[i];
     }
-    //  save for the next frame
-    std::copy(phases_curr.begin(), phases_curr.end(), phases_prev.begin());
   }
 
-  polar_to_cartesian(dft, amps_curr, phases_curr, frame_size());
-  ifft.exec();
-
   frame++;
-
-  // all blocks need to be modified (phase shifted)
-  return false;
 }
 
-PhaseExtractor::PhaseExtractor(std::size_t frame_size,
-                               std::size_t bin_from,
-                               std::size_t bin_to)
-    : Extractor<double>(frame_size),
+template <typename T>
+PhaseExtractor<T>::PhaseExtractor(std::size_t frame_size,
+                                  std::size_t bin_from,
+                                  std::size_t bin_to)
+    : Extractor<T>(frame_size),
       bin_from(bin_from),
       bin_to(bin_to),
-      phases(in_frame.size()),
-      dft(in_frame.size()),
-      fft(in_frame.size(), in_frame, dft)
+      phases(this->in_frame.size()),
+      dft(this->in_frame.size()),
+      fft(this->in_frame.size(), this->in_frame, dft),
+      batch(frame_size, frame_size, frame_size, false)
 {
 }
 
-bool PhaseExtractor::extract(OutBitStream& data)
+template <typename T>
+bool PhaseExtractor<T>::extract(OutBitStream& data)
 {
   fft.exec();
-  angle(dft, phases, in_frame.size());
+  angle(dft, phases, this->in_frame.size());
   decodeBlock(phases, data);
   return false;  // information is only in the first frame
 }
 
-void PhaseExtractor::decodeBlock(const std::vector<double>& phases,
-                                 OutBitStream& data)
+template <typename T>
+bool PhaseExtractor<T>::extract_frames(const PlanarBlock<const T>& block,
+                                       OutBitStream& data)
+{
+  // information is only in the first frame
+  const unsigned channels = block.channels();
+
+  batch.forward(block.data(), channels);
+  for (unsigned ch = 0; ch < channels; ch++) {
+    if (data.eof())
+      return false;
+    angle(batch.spectrum(ch), phases.data(), this->in_frame.size());
+    decodeBlock(phases, data);
+  }
+  return false;
+}
+
+template <typename T>
+void PhaseExtractor<T>::decodeBlock(const aligned_vector<T>& phases,
+                                    OutBitStream& data)
 {
 #if 0
   for (int i = segment_size / 2; i >= 0; i--) {
@@ -210,3 +249,8 @@ void PhaseExtractor::decodeBlock(const std::vector<double>& phases,
   }
 #endif
 }
+
+template class PhaseEmbedder<double>;
+template class PhaseEmbedder<float>;
+template class PhaseExtractor<double>;
+template class PhaseExtractor<float>;
@@ -26,6 +26,7 @@
 #include <ostream>
 #include <vector>
 
+#include "channel_batch.h"
 #include "dsp_utils.h"
 #include "embedder.h"
 #include "extractor.h"
@@ -44,9 +45,11 @@ class PhaseMethod : public Method {
   int bin_from;
   int bin_to;
   std::size_t frame_size;
+  bool single;
 };
 
-class PhaseEmbedder : public Embedder<double> {
+template <typename T>
+class PhaseEmbedder : public Embedder<T> {
  public:
   PhaseEmbedder(InBitStream& data,
                 std::size_t frame_size,
@@ -55,30 +58,39 @@ class PhaseEmbedder : public Embedder<double> {
 
   bool embed() override;
 
+  bool embed_frames(const PlanarBlock<T>& block) override;
+
  protected:
   std::size_t frame = 0;
 
-  std::size_t encodeFirstBlock(std::vector<double>& phases);
+  std::size_t encodeFirstBlock(aligned_vector<T>& phases);
+
+  /**
+   * @brief Modulate the phases of the spectrum of the current frame.
+   */
+  void modulate(std::complex<T>* dft);
 
  private:
   std::size_t bin_from;
   std::size_t bin_to;
 
-  std::vector<double> amps_curr;
-  std::vector<double> phases_prev;
-  std::vector<double> phases_curr;
-  std::vector<double> backup;
+  aligned_vector<T> amps_curr;
+  aligned_vector<T> phases_curr;
+
+  // the phase shifts of the first frame applied to all the following frames
+  aligned_vector<std::complex<T>> rotor;
 
-  std::vector<double> diff_curr;
+  aligned_vector<std::complex<T>> dft;
+  FFT<T> fft;
+  IFFT<T> ifft;
 
-  std::vector<std::complex<double>> dft;
-  FFT fft;
-  IFFT ifft;
+  ChannelBatch<T> batch;
 
   std::size_t encoded;
 };
 
-class PhaseExtractor : public Extractor<double> {
+template <typename T>
+class PhaseExtractor : public Extractor<T> {
  public:
   PhaseExtractor(std::size_t frame_size,
                  std::size_t bin_from,
@@ -86,15 +98,20 @@ class PhaseExtractor : public Extractor<double> {
 
   bool extract(OutBitStream& data) override;
 
+  bool extract_frames(const PlanarBlock<const T>& block,
+                      OutBitStream& data) override;
+
  private:
-  void decodeBlock(const std::vector<double>& phases, OutBitStream& data);
+  void decodeBlock(const aligned_vector<T>& phases, OutBitStream& data);
 
   std::size_t bin_from;
   std::size_t bin_to;
 
-  std::vector<double> phases;
-  std::vector<std::complex<double>> dft;
-  FFT fft;
+  aligned_vector<T> phases;
+  aligned_vector<std::complex<T>> dft;
+  FFT<T> fft;
+
+  ChannelBatch<T> batch;
 };
 
 #endif
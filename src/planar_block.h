@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PLANAR_BLOCK_H
+#define PLANAR_BLOCK_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include "aligned_vector.h"
+#include "interleave.h"
+
+/**
+ * @brief A view of consecutive frames of all channels in planar layout.
+ *
+ * The frames follow one after another, each holding the samples of the
+ * channels one after another. The i-th frame of a single channel in the order
+ * of processing is the channel i % channels() of the frame i / channels().
+ * The view does not own the samples.
+ * @tparam T The data type of samples, const for read-only views.
+ */
+template <typename T>
+class PlanarBlock {
+ public:
+  /**
+   * @brief Constructor.
+   * @param data The first sample of the block.
+   * @param frames The number of frames.
+   * @param channels The number of channels.
+   * @param frame_size The number of samples in each channel of a frame.
+   */
+  PlanarBlock(T* data,
+              std::size_t frames,
+              unsigned channels,
+              std::size_t frame_size)
+      : _data(data),
+        _frames(frames),
+        _channels(channels),
+        _frame_size(frame_size)
+  {
+  }
+
+  /**
+   * @brief Constructor making a read-only view of a block.
+   */
+  template <typename U,
+            typename = std::enable_if_t<std::is_same_v<const U, T>>>
+  PlanarBlock(const PlanarBlock<U>& block)
+      : PlanarBlock(block.data(),
+                    block.frames(),
+                    block.channels(),
+                    block.frame_size())
+  {
+  }
+
+  /**
+   * @brief Get the first sample of the block.
+   */
+  T* data() const { return _data; }
+
+  /**
+   * @brief Get the number of frames.
+   */
+  std::size_t frames() const { return _frames; }
+
+  /**
+   * @brief Get the number of channels.
+   */
+  unsigned channels() const { return _channels; }
+
+  /**
+   * @brief Get the number of samples in each channel of a frame.
+   */
+  std::size_t frame_size() const { return _frame_size; }
+
+  /**
+   * @brief Get the number of frames of single channels, frames() * channels().
+   */
+  std::size_t count() const { return _frames * _channels; }
+
+  /**
+   * @brief Get the number of samples in the block.
+   */
+  std::size_t size() const { return count() * _frame_size; }
+
+  /**
+   * @brief Get the i-th frame of a single channel in the order of processing.
+   */
+  T* frame(std::size_t i) const { return _data + i * _frame_size; }
+
+  /**
+   * @brief Get the given channel of the given frame.
+   */
+  T* frame(std::size_t f, unsigned ch) const
+  {
+    return frame(f * _channels + ch);
+  }
+
+ private:
+  T* _data;
+  std::size_t _frames;
+  unsigned _channels;
+  std::size_t _frame_size;
+};
+
+/**
+ * @brief The staging buffer converting interleaved signal to planar blocks.
+ *
+ * The frames of interleaved signal are deinterleaved into the buffer and
+ * interleaved back after processing. Mono signal is already planar, so it is
+ * viewed in place without any copying.
+ * @tparam T The data type of samples.
+ */
+template <typename T>
+class PlanarBuffer {
+ public:
+  /**
+   * @brief Constructor.
+   * @param block_size The maximum number of frames in a block.
+   * @param frame_size The number of samples in each channel of a frame.
+   * @param channels The number of channels.
+   */
+  PlanarBuffer(std::size_t block_size,
+               std::size_t frame_size,
+               unsigned channels)
+      : frame_size(frame_size),
+        channels(channels),
+        staging(channels > 1 ? block_size * frame_size * channels : 0)
+  {
+  }
+
+  /**
+   * @brief View the frames of interleaved signal as a planar block.
+   * @param interleaved The interleaved signal.
+   * @param frames The number of frames, at most block_size.
+   * @return The block, valid until the next call.
+   */
+  PlanarBlock<T> load(T* interleaved, std::size_t frames)
+  {
+    if (channels == 1)
+      return PlanarBlock<T>(interleaved, frames, channels, frame_size);
+
+    deinterleave_frames(interleaved, staging.data(), frames, frame_size,
+                        channels);
+    return PlanarBlock<T>(staging.data(), frames, channels, frame_size);
+  }
+
+  /**
+   * @brief View the frames of interleaved signal as a read-only planar block.
+   * @param interleaved The interleaved signal.
+   * @param frames The number of frames, at most block_size.
+   * @return The block, valid until the next call.
+   */
+  PlanarBlock<const T> load(const T* interleaved, std::size_t frames)
+  {
+    if (channels == 1)
+      return PlanarBlock<const T>(interleaved, frames, channels, frame_size);
+
+    deinterleave_frames(interleaved, staging.data(), frames, frame_size,
+                        channels);
+    return PlanarBlock<const T>(staging.data(), frames, channels, frame_size);
+  }
+
+  /**
+   * @brief Write a block returned by load() back to the interleaved signal.
+   * @param block The block.
+   * @param interleaved The interleaved signal the block was loaded from.
+   */
+  void store(const PlanarBlock<T>& block, T* interleaved)
+  {
+    if (block.data() != interleaved)
+      interleave_frames(block.data(), interleaved, block.frames(), frame_size,
+                        channels);
+  }
+
+ private:
+  std::size_t frame_size;
+  unsigned channels;
+  aligned_vector<T> staging;
+};
+
+#endif  // PLANAR_BLOCK_H
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+#include "planner.h"
+
+// creating and destroying FFTW plans is not thread safe, executing them is
+static std::mutex planner_mutex;
+
+static std::atomic<unsigned> flags{FFTW_ESTIMATE};
+
+void set_planner_rigor(const std::string& rigor)
+{
+  if (rigor == "estimate")
+    flags = FFTW_ESTIMATE;
+  else if (rigor == "measure")
+    flags = FFTW_MEASURE;
+  else if (rigor == "patient")
+    flags = FFTW_PATIENT;
+  else if (rigor == "exhaustive")
+    flags = FFTW_EXHAUSTIVE;
+  else
+    throw std::invalid_argument("unknown planner rigor: " + rigor);
+}
+
+unsigned planner_flags()
+{
+  return flags;
+}
+
+std::string default_wisdom_file()
+{
+  if (const char* file = std::getenv("STEGO_WISDOM"))
+    return file;
+
+  std::filesystem::path cache;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+    cache = xdg;
+  else if (const char* home = std::getenv("HOME"))
+    cache = std::filesystem::path(home) / ".cache";
+  else
+    return "";
+
+  return cache / "stego" / "wisdom";
+}
+
+// the wisdom of the single precision is kept in a separate file
+static std::string float_wisdom_file(const std::string& filename)
+{
+  return filename + ".float";
+}
+
+bool import_wisdom(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  // the single precision wisdom is optional, older files don't have it
+  fftw_traits<float>::import_wisdom(float_wisdom_file(filename).c_str());
+  return fftw_traits<double>::import_wisdom(filename.c_str());
+}
+
+bool export_wisdom(const std::string& filename)
+{
+  std::filesystem::path dir = std::filesystem::path(filename).parent_path();
+  std::error_code ec;
+  if (!dir.empty())
+    std::filesystem::create_directories(dir, ec);
+
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  return fftw_traits<double>::export_wisdom(filename.c_str()) &&
+         fftw_traits<float>::export_wisdom(
+             float_wisdom_file(filename).c_str());
+}
+
+using plan_key =
+    std::tuple<PlanKind, unsigned, int, unsigned, unsigned, unsigned, unsigned>;
+
+// the registry of each precision
+template <typename T>
+static std::map<plan_key, typename fftw_traits<T>::plan> plans;
+
+/**
+ * @brief Array for planning with the given alignment.
+ */
+template <typename T>
+class ScratchArray {
+ public:
+  ScratchArray(std::size_t n, int alignment)
+      : buffer(static_cast<T*>(fftw_traits<T>::malloc((n + 8) * sizeof(T))))
+  {
+    data = reinterpret_cast<T*>(reinterpret_cast<char*>(buffer) + alignment);
+  }
+
+  ~ScratchArray() { fftw_traits<T>::free(buffer); }
+
+  T* data;
+
+ private:
+  T* buffer;
+};
+
+template <typename T>
+typename fftw_traits<T>::plan shared_plan(PlanKind kind,
+                                         unsigned N,
+                                         int alignment,
+                                         unsigned howmany,
+                                         unsigned idist,
+                                         unsigned odist)
+{
+  using traits = fftw_traits<T>;
+  using complex = typename traits::complex;
+
+  // the distances don't matter for a single transform
+  if (howmany == 1)
+    idist = odist = 0;
+
+  const unsigned plan_flags = planner_flags();
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  typename traits::plan& plan = plans<T>[plan_key(
+      kind, N, alignment, plan_flags, howmany, idist, odist)];
+  if (plan)
+    return plan;
+
+  // the complex arrays of N / 2 + 1 elements fit into N + 2 reals, the
+  // distances of complex arrays are in complex elements
+  const bool complex_in = kind == PlanKind::C2R;
+  const bool complex_out = kind == PlanKind::R2C;
+  ScratchArray<T> in((howmany - 1) * idist * (complex_in ? 2 : 1) + N + 2,
+                     alignment / 64);
+  ScratchArray<T> out((howmany - 1) * odist * (complex_out ? 2 : 1) + N + 2,
+                      alignment % 64);
+  if (howmany > 1) {
+    switch (kind) {
+      case PlanKind::R2C:
+        plan = traits::plan_many_r2c(N, howmany, in.data, idist,
+                                     reinterpret_cast<complex*>(out.data),
+                                     odist, plan_flags);
+        break;
+      case PlanKind::C2R:
+        plan = traits::plan_many_c2r(N, howmany,
+                                     reinterpret_cast<complex*>(in.data),
+                                     idist, out.data, odist, plan_flags);
+        break;
+      case PlanKind::REDFT00:
+        plan = traits::plan_many_r2r(N, howmany, in.data, idist, out.data,
+                                     odist, FFTW_REDFT00, plan_flags);
+        break;
+    }
+    return plan;
+  }
+
+  switch (kind) {
+    case PlanKind::R2C:
+      plan = traits::plan_r2c(N, in.data, reinterpret_cast<complex*>(out.data),
+                              plan_flags);
+      break;
+    case PlanKind::C2R:
+      plan = traits::plan_c2r(N, reinterpret_cast<complex*>(in.data), out.data,
+                              plan_flags);
+      break;
+    case PlanKind::REDFT00:
+      plan = traits::plan_r2r(N, in.data, out.data, FFTW_REDFT00, plan_flags);
+      break;
+  }
+  return plan;
+}
+
+template fftw_plan shared_plan<double>(PlanKind,
+                                       unsigned,
+                                       int,
+                                       unsigned,
+                                       unsigned,
+                                       unsigned);
+template fftwf_plan shared_plan<float>(PlanKind,
+                                       unsigned,
+                                       int,
+                                       unsigned,
+                                       unsigned,
+                                       unsigned);
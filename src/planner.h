@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file planner.h
+ * @brief The global configuration of the FFTW planner.
+ */
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <string>
+
+#include "fftw_traits.h"
+
+/**
+ * @brief Set the rigor of the planner for the plans created from now on.
+ * @param rigor One of estimate, measure, patient or exhaustive.
+ * @throws std::invalid_argument If the rigor is not recognized.
+ */
+void set_planner_rigor(const std::string& rigor);
+
+/**
+ * @brief Get the planner flags of the current rigor.
+ * FFTW_ESTIMATE unless set otherwise.
+ */
+unsigned planner_flags();
+
+/**
+ * @brief Get the default file for the FFTW wisdom.
+ *
+ * The STEGO_WISDOM environment variable if set, otherwise stego/wisdom in
+ * $XDG_CACHE_HOME or $HOME/.cache.
+ * @return The path of the file or an empty string if none can be determined.
+ */
+std::string default_wisdom_file();
+
+/**
+ * @brief Add the wisdom from the file to the current wisdom.
+ * The wisdom of the single precision is kept next to the file, with the .float
+ * suffix.
+ * @return False if the file can't be read, else true.
+ */
+bool import_wisdom(const std::string& filename);
+
+/**
+ * @brief Save the current wisdom to the file.
+ * The missing directories of the file are created. The wisdom of the single
+ * precision is saved next to the file, with the .float suffix.
+ * @return False if the file can't be written, else true.
+ */
+bool export_wisdom(const std::string& filename);
+
+/**
+ * @brief The kinds of transforms in the plan registry.
+ */
+enum class PlanKind {
+  R2C,      // real to complex DFT
+  C2R,      // complex to real inverse DFT
+  REDFT00,  // DCT-I
+};
+
+/**
+ * @brief Get the alignment of the arrays of a transform.
+ * @tparam T The precision of the transform.
+ * Plans can only be executed on arrays with the alignment they were created
+ * for.
+ * @param in The input array.
+ * @param out The output array, distinct from the input.
+ * @return The alignment to pass to shared_plan().
+ */
+template <typename T>
+int plan_alignment(void* in, void* out)
+{
+  return fftw_traits<T>::alignment_of(static_cast<T*>(in)) * 64 +
+         fftw_traits<T>::alignment_of(static_cast<T*>(out));
+}
+
+/**
+ * @brief Get a plan from the process-wide plan registry.
+ *
+ * The plans are shared by all callers with the same kind, size, batch layout
+ * and alignment of arrays, and planned with the current planner flags on the
+ * first request.
+ * They are planned on scratch arrays and must be run with the new-array
+ * execute functions, e.g. fftw_traits<T>::execute_r2c(), on distinct input and
+ * output arrays. The plans live until the end of the process. This function
+ * is thread-safe.
+ * @tparam T The precision of the transform, double or float.
+ * @param kind The kind of the transform.
+ * @param N The length of the transform.
+ * @param alignment The alignment of the arrays, see plan_alignment().
+ * @param howmany The number of transforms in a batch, one after another in
+ * the arrays.
+ * @param idist The distance between the inputs of a batch, in elements.
+ * @param odist The distance between the outputs of a batch, in elements.
+ * @return The plan.
+ */
+template <typename T>
+typename fftw_traits<T>::plan shared_plan(PlanKind kind,
+                                         unsigned N,
+                                         int alignment,
+                                         unsigned howmany = 1,
+                                         unsigned idist = 0,
+                                         unsigned odist = 0);
+
+#endif  // PLANNER_H
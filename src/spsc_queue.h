@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer queue.
+ *
+ * Exactly one thread may push and exactly one thread may pop at a time. The
+ * queue is a ring buffer indexed by two ever increasing counters, the
+ * producer only writes the tail and the consumer only writes the head.
+ * @tparam T The type of the elements, should be cheap to copy.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  /**
+   * @brief Constructor.
+   * @param capacity The maximum number of elements in the queue.
+   */
+  SpscQueue(std::size_t capacity) : slots(capacity) {}
+
+  /**
+   * @brief Append an element to the queue.
+   * @param value The element to append.
+   * @return False if the queue is full, else true.
+   */
+  bool try_push(const T& value)
+  {
+    const std::size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size())
+      return false;
+
+    slots[t % slots.size()] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the first element from the queue.
+   * @param value The buffer for the removed element.
+   * @return False if the queue is empty, else true.
+   */
+  bool try_pop(T& value)
+  {
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return false;
+
+    value = slots[h % slots.size()];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Append an element, wait while the queue is full.
+   * @param value The element to append.
+   */
+  void push(const T& value)
+  {
+    while (!try_push(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Remove the first element, wait while the queue is empty.
+   * @param value The buffer for the removed element.
+   * @param cancel Stop waiting and return false once this is set.
+   * @return False if the wait was cancelled, else true.
+   */
+  bool pop(T& value, const std::atomic<bool>* cancel = nullptr)
+  {
+    while (!try_pop(value)) {
+      if (cancel && cancel->load(std::memory_order_acquire))
+        return false;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+ private:
+  std::vector<T> slots;
+  // the counters are kept in separate cache lines to avoid false sharing
+  alignas(64) std::atomic<std::size_t> head{0};
+  alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+#endif  // SPSC_QUEUE_H
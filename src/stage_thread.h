@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+/**
+ * @file stage_thread.h
+ * @brief A thread of a stage of the pipelined file processing.
+ */
+#ifndef STAGE_THREAD_H
+#define STAGE_THREAD_H
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief A thread running a stage of a pipeline, joined on destruction.
+ *
+ * The stages share a stop flag, all their waits on the queues between them
+ * are cancelled once it is set. An exception thrown by the stage sets the
+ * flag and is rethrown by join(). The destructor sets the flag before
+ * joining, so an exception on the thread owning the stage can't leave it
+ * waiting forever.
+ */
+class StageThread {
+ public:
+  /**
+   * @brief Constructor, start the stage.
+   * @param stop The stop flag of the pipeline.
+   * @param stage The function of the stage.
+   */
+  template <typename F>
+  StageThread(std::atomic<bool>& stop, F stage)
+      : stop(stop), thread([this, stage = std::move(stage)]() mutable {
+          try {
+            stage();
+          } catch (...) {
+            error = std::current_exception();
+            this->stop = true;
+          }
+        })
+  {
+  }
+
+  StageThread(const StageThread&) = delete;
+  StageThread& operator=(const StageThread&) = delete;
+
+  /**
+   * @brief Destructor, stop the pipeline and wait for the stage to finish,
+   * unless already joined.
+   */
+  ~StageThread()
+  {
+    if (thread.joinable()) {
+      stop = true;
+      thread.join();
+    }
+  }
+
+  /**
+   * @brief Wait for the stage to finish.
+   * @throws The exception thrown by the stage, if any.
+   */
+  void join()
+  {
+    thread.join();
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+ private:
+  std::atomic<bool>& stop;
+  std::exception_ptr error;
+  // the last member, the stage may only start once the others are constructed
+  std::thread thread;
+};
+
+#endif  // STAGE_THREAD_H
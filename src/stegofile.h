@@ -17,14 +17,24 @@
 #ifndef STEGOFILE_H
 #define STEGOFILE_H
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <sndfile.hh>
 
 #include "audioparams.h"
+#include "bitvector.h"
 #include "dsp_utils.h"
 #include "extractor.h"
+#include "obitstream.h"
+#include "planar_block.h"
+#include "spsc_queue.h"
+#include "stage_thread.h"
+#include "thread_pool.h"
 
 /**
  * @brief Stego file.
@@ -48,31 +58,243 @@ class StegoFile {
    * @brief Extract the embedded data.
    * @params extractor The Extractor to extract data with.
    * @params output The bitstream to write the extracted data to.
+   * @params block_size The number of frames extracted from at once.
    */
   template <typename T>
-  void extract(Extractor<T>& extractor, OutBitStream& output)
+  void extract(Extractor<T>& extractor,
+               OutBitStream& output,
+               std::size_t block_size = DEF_BLOCK_FRAMES)
   {
-    std::vector<T> buffer(extractor.frame_size() * stego.channels());
+    const int channels = stego.channels();
+    const std::size_t frame_size = extractor.frame_size();
+    aligned_vector<T> buffer(block_size * frame_size * channels);
+    PlanarBuffer<T> planar(block_size, frame_size, channels);
 
     sf_count_t read = 0;
-    bool should_continue = true;
-    while ((read = stego.readf(buffer.data(), extractor.frame_size())) > 0) {
-      if ((unsigned)read != extractor.frame_size())
+    while ((read = stego.readf(buffer.data(), block_size * frame_size)) > 0) {
+      // safe cast, read is > 0, only whole frames carry data
+      const std::size_t frames = (std::size_t)read / frame_size;
+      if (frames == 0)
+        break;
+
+      const T* samples = buffer.data();
+      if (!extractor.extract_frames(planar.load(samples, frames), output))
         break;
+    }
+  }
+
+  /**
+   * @brief Extract data embedded with CoverFile::embed_channels().
+   *
+   * Each channel is processed by its own extractor on a pool of one thread per
+   * channel, an exception of any of them is rethrown after all channels of
+   * the chunk are processed. The extracted bits are interleaved back in the
+   * order they were distributed among the channels.
+   * @params make_extractor A function creating an extractor.
+   * @params output The bitstream to write the extracted data to.
+   */
+  template <typename Factory>
+  void extract_channels(Factory make_extractor, OutBitStream& output)
+  {
+    using T = typename decltype(make_extractor())::element_type::sample_type;
+
+    const int channels = stego.channels();
+    std::vector<std::unique_ptr<Extractor<T>>> extractors;
+    for (int ch = 0; ch < channels; ch++) {
+      extractors.push_back(make_extractor());
+    }
+
+    const std::size_t frame_size = extractors[0]->frame_size();
+    std::vector<T> buffer(CHANNEL_BLOCK_FRAMES * frame_size * channels);
+    std::vector<char> stopped(channels, false);
+    std::vector<std::deque<bool>> pending(channels);
+    std::size_t next = 0;  // the channel holding the next bit
+    ThreadPool pool(channels);
+
+    sf_count_t read = 0;
+    while ((read = stego.readf(buffer.data(),
+                               CHANNEL_BLOCK_FRAMES * frame_size)) > 0) {
+      // safe cast, read is > 0, only whole frames carry data
+      const std::size_t frames = (std::size_t)read / frame_size;
+
+      std::vector<VectorOutBitStream> extracted(channels);
+      pool.run_all(channels, [&](std::size_t ch) {
+        Extractor<T>& extractor = *extractors[ch];
+        for (std::size_t f = 0; f < frames && !stopped[ch]; f++) {
+          const T* frame = buffer.data() + f * frame_size * channels;
+          demultiplex(frame, extractor.input().data(), frame_size, ch,
+                      channels);
+          stopped[ch] = !extractor.extract(extracted[ch]);
+        }
+      });
+
+      for (int ch = 0; ch < channels; ch++) {
+        BitVector bits = extracted[ch].to_vector();
+        for (std::size_t i = 0; i < bits.size(); i++) {
+          pending[ch].push_back(bits[i]);
+        }
+      }
+      if (!merge(pending, stopped, next, output) ||
+          frames < CHANNEL_BLOCK_FRAMES)
+        return;
+    }
+  }
+
+  /**
+   * @brief Extract the embedded data, overlapping decoding and extraction.
+   *
+   * The stego file is read by a reader thread while the extraction runs on
+   * the calling thread, the blocks of frames are passed through lock-free
+   * queues. An exception of the reader is rethrown here. The result is the
+   * same as with extract().
+   * @params extractor The Extractor to extract data with.
+   * @params output The bitstream to write the extracted data to.
+   * @params block_size The number of frames in each block.
+   */
+  template <typename T>
+  void extract_pipelined(Extractor<T>& extractor,
+                         OutBitStream& output,
+                         std::size_t block_size = PIPELINE_BLOCK_FRAMES)
+  {
+    const int channels = stego.channels();
+    const std::size_t frame_size = extractor.frame_size();
+    const sf_count_t block_frames = block_size * frame_size;
+
+    std::vector<aligned_vector<T>> blocks(
+        PIPELINE_BLOCKS, aligned_vector<T>(block_frames * channels));
+    std::vector<sf_count_t> read(PIPELINE_BLOCKS);
 
-      for (int ch = 0; ch < stego.channels(); ch++) {
-        demultiplex(buffer, extractor.input(), ch, stego.channels());
-        if (output.eof())
+    // the blocks are passed around by their indices
+    SpscQueue<std::size_t> free_blocks(PIPELINE_BLOCKS);
+    SpscQueue<std::size_t> filled_blocks(PIPELINE_BLOCKS);
+    for (std::size_t i = 0; i < PIPELINE_BLOCKS; i++) {
+      free_blocks.push(i);
+    }
+
+    // set when the extraction ends before the end of the file or the reader
+    // fails
+    std::atomic<bool> stop{false};
+    // a block with nothing read marks the end of the file
+    StageThread reader(stop, [&] {
+      std::size_t i;
+      do {
+        if (!free_blocks.pop(i, &stop))
           return;
+        read[i] = stego.readf(blocks[i].data(), block_frames);
+        filled_blocks.push(i);
+      } while (read[i] > 0);
+    });
 
-        should_continue &= extractor.extract(output);
+    PlanarBuffer<T> planar(block_size, frame_size, channels);
+
+    bool should_continue = true;
+    std::size_t i;
+    while (should_continue && filled_blocks.pop(i, &stop) && read[i] > 0) {
+      // safe cast, read is > 0, only whole frames carry data
+      const std::size_t frames = (std::size_t)read[i] / frame_size;
+      if (frames > 0) {
+        const T* samples = blocks[i].data();
+        should_continue =
+            extractor.extract_frames(planar.load(samples, frames), output);
       }
-      if (!should_continue)
-        break;
+      if (frames < block_size)
+        should_continue = false;
+      free_blocks.push(i);
+    }
+
+    stop = true;
+    reader.join();
+  }
+
+  /**
+   * @brief Extract the embedded data by segments in parallel.
+   *
+   * The file is read in chunks, the frames of each chunk are split into
+   * contiguous segments, one for each thread of a pool with its own
+   * extractor. The bits of the segments are buffered and written to the
+   * output in the order of the segments. This only works for methods
+   * extracting each frame independently, see
+   * Method::independent_extraction(). An exception of any worker is rethrown
+   * after all segments of the chunk are processed. The result is the same as
+   * with extract().
+   * @params make_extractor A function creating an extractor.
+   * @params output The bitstream to write the extracted data to.
+   * @params jobs The number of worker threads.
+   */
+  template <typename Factory>
+  void extract_segments(Factory make_extractor,
+                        OutBitStream& output,
+                        unsigned jobs)
+  {
+    using T = typename decltype(make_extractor())::element_type::sample_type;
+
+    const int channels = stego.channels();
+    std::vector<std::unique_ptr<Extractor<T>>> extractors;
+    for (unsigned w = 0; w < jobs; w++) {
+      extractors.push_back(make_extractor());
+    }
+
+    const std::size_t frame_size = extractors[0]->frame_size();
+    const std::size_t chunk_frames = jobs * SEGMENT_BLOCK_FRAMES;
+    std::vector<T> buffer(chunk_frames * frame_size * channels);
+    ThreadPool pool(jobs);
+
+    sf_count_t read = 0;
+    while ((read = stego.readf(buffer.data(), chunk_frames * frame_size)) >
+           0) {
+      // safe cast, read is > 0, only whole frames carry data
+      const std::size_t frames = (std::size_t)read / frame_size;
+
+      std::vector<VectorOutBitStream> segments(jobs);
+      pool.run_all(jobs, [&](std::size_t w) {
+        Extractor<T>& extractor = *extractors[w];
+        for (std::size_t f = frames * w / jobs; f < frames * (w + 1) / jobs;
+             f++) {
+          const T* frame = buffer.data() + f * frame_size * channels;
+          for (int ch = 0; ch < channels; ch++) {
+            demultiplex(frame, extractor.input().data(), frame_size, ch,
+                        channels);
+            // the extractors of these methods never stop on their own
+            (void)extractor.extract(segments[w]);
+          }
+        }
+      });
+
+      for (const VectorOutBitStream& segment : segments) {
+        BitVector bits = segment.to_vector();
+        for (std::size_t i = 0; i < bits.size(); i++) {
+          if (output.eof())
+            return;
+          output.output_bit(bits[i]);
+        }
+      }
+      if (frames < chunk_frames)
+        return;
     }
   }
 
  private:
+  /**
+   * @brief Write the pending bits of the channels to the output in order.
+   * @return False if nothing more can be extracted, else true.
+   */
+  static bool merge(std::vector<std::deque<bool>>& pending,
+                    const std::vector<char>& stopped,
+                    std::size_t& next,
+                    OutBitStream& output)
+  {
+    while (!output.eof()) {
+      std::deque<bool>& bits = pending[next];
+      if (bits.empty())
+        return !stopped[next];
+
+      output.output_bit(bits.front());
+      bits.pop_front();
+      next = (next + 1) % pending.size();
+    }
+    return false;
+  }
+
   SndfileHandle stego;
 };
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+  for (unsigned i = 0; i < threads; i++) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  task_ready.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::submit(Task task)
+{
+  {
+    // the counters must not be decremented before they are incremented
+    std::lock_guard<std::mutex> lock(mutex);
+    Queue& queue = *queues[next];
+    next = (next + 1) % queues.size();
+    {
+      std::lock_guard<std::mutex> queue_lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    queued++;
+    unfinished++;
+  }
+  task_ready.notify_one();
+}
+
+void ThreadPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  all_done.wait(lock, [this] { return unfinished == 0; });
+}
+
+void ThreadPool::run_all(std::size_t n,
+                         const std::function<void(std::size_t)>& f)
+{
+  std::vector<std::exception_ptr> errors(n);
+  for (std::size_t i = 0; i < n; i++) {
+    submit([&, i] {
+      try {
+        f(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  wait();
+
+  for (const std::exception_ptr& error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
+bool ThreadPool::take(std::size_t worker, Task& task)
+{
+  for (std::size_t i = 0; i < queues.size(); i++) {
+    Queue& queue = *queues[(worker + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+
+    // the own queue is used as a stack, the others are stolen from
+    if (i == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::work(std::size_t worker)
+{
+  while (true) {
+    Task task;
+    if (take(worker, task)) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued--;
+      }
+      task();
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--unfinished == 0)
+        all_done.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    task_ready.wait(lock, [this] { return stop || queued > 0; });
+    if (stop && queued == 0)
+      return;
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2023 Matej Matuska
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A work-stealing pool of threads.
+ *
+ * Every worker has its own queue of tasks. The tasks are distributed among the
+ * queues round-robin, a worker takes the tasks from the back of its own queue
+ * and when it runs out of them, it steals from the front of the other queues.
+ * The tasks must not throw, see run_all() for tasks which may.
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   * @brief Constructor.
+   * @param threads The number of worker threads, at least 1.
+   */
+  ThreadPool(unsigned threads);
+
+  /**
+   * @brief Destructor.
+   * Waits for all submitted tasks to finish.
+   */
+  ~ThreadPool();
+
+  /**
+   * @brief Submit a task for execution.
+   * @param task The task to run.
+   */
+  void submit(Task task);
+
+  /**
+   * @brief Wait for all submitted tasks to finish.
+   */
+  void wait();
+
+  /**
+   * @brief Run the function for each index from 0 to n - 1 on the pool and
+   * wait for all submitted tasks to finish.
+   *
+   * The calls may throw, the first exception by the index is rethrown once
+   * all of them finished. Must not be called from the tasks of the pool.
+   * @param n The number of calls.
+   * @param f The function taking the index.
+   */
+  void run_all(std::size_t n, const std::function<void(std::size_t)>& f);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  /**
+   * @brief Take a task, from the worker's own queue or steal one.
+   * @return False if all queues are empty, else true.
+   */
+  bool take(std::size_t worker, Task& task);
+
+  void work(std::size_t worker);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  // guards the members below
+  std::mutex mutex;
+  std::size_t next = 0;  // the queue for the next submitted task
+  std::condition_variable task_ready;
+  std::condition_variable all_done;
+  std::size_t queued = 0;      // tasks waiting in the queues
+  std::size_t unfinished = 0;  // tasks submitted but not finished
+  bool stop = false;
+};
+
+#endif  // THREAD_POOL_H
@@ -14,9 +14,12 @@
  * You should have received a copy of the GNU General Public License along with
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <cmath>
 #include <complex>
 #include <cstdio>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "dsp_utils.h"
@@ -26,6 +29,28 @@
 #define EMBEDDING_PWR_PCT 0.25
 #define OTHER_PWR_PCT 0.001
 
+/**
+ * @brief Parse the carriers from the format "f0:f1/f0:f1/...".
+ */
+static std::vector<ToneCarrier> parse_carriers(const std::string& str)
+{
+  std::vector<ToneCarrier> carriers;
+  std::istringstream is{str};
+  std::string carrier;
+  while (std::getline(is, carrier, '/')) {
+    std::size_t colon = carrier.find(':');
+    if (colon == std::string::npos)
+      throw std::invalid_argument("invalid carrier: " + carrier);
+    try {
+      carriers.emplace_back(std::stoul(carrier.substr(0, colon)),
+                            std::stoul(carrier.substr(colon + 1)));
+    } catch (const std::logic_error& e) {
+      throw std::invalid_argument("invalid carrier: " + carrier);
+    }
+  }
+  return carriers;
+}
+
 ToneInsertionMethod::ToneInsertionMethod(const Params& params)
 {
   frame_size = params.get_or("framesize", 1024);
@@ -34,99 +59,311 @@ ToneInsertionMethod::ToneInsertionMethod(const Params& params)
 
   samplerate = params.get_ul("samplerate");
 
-  freq0 = params.get_or("freq0", 1875);
-  if (freq0 > samplerate / 2)
-    throw std::invalid_argument("freq0 must be lower than samplerate / 2");
+  carriers = parse_carriers(params.get_or("carriers", std::string()));
+  if (carriers.empty()) {
+    unsigned freq0 = params.get_or("freq0", 1875);
+    unsigned freq1 = params.get_or("freq1", 2625);
+    carriers.emplace_back(freq0, freq1);
+  }
+
+  for (const auto& [freq0, freq1] : carriers) {
+    if (freq0 > samplerate / 2)
+      throw std::invalid_argument("freq0 must be lower than samplerate / 2");
+    if (freq1 > samplerate / 2)
+      throw std::invalid_argument("freq1 must be lower than samplerate / 2");
+  }
 
-  freq1 = params.get_or("freq1", 2625);
-  if (freq1 > samplerate / 2)
-    throw std::invalid_argument("freq1 must be lower than samplerate / 2");
+  single = single_precision(params);
 }
 
 embedder_variant ToneInsertionMethod::make_embedder(InBitStream& input) const
 {
-  return make_unique<ToneInsertionEmbedder>(input, frame_size, samplerate,
-                                            freq0, freq1);
+  if (single)
+    return make_unique<ToneInsertionEmbedder<float>>(input, frame_size,
+                                                     samplerate, carriers);
+  return make_unique<ToneInsertionEmbedder<double>>(input, frame_size,
+                                                    samplerate, carriers);
 }
 
 extractor_variant ToneInsertionMethod::make_extractor() const
 {
-  return make_unique<ToneInsertionExtractor>(frame_size, samplerate, freq0,
-                                             freq1);
+  if (single)
+    return make_unique<ToneInsertionExtractor<float>>(frame_size, samplerate,
+                                                      carriers);
+  return make_unique<ToneInsertionExtractor<double>>(frame_size, samplerate,
+                                                     carriers);
 }
 
 ssize_t ToneInsertionMethod::capacity(std::size_t samples) const
 {
-  return std::round(samples / (double)frame_size);
+  return std::round(samples / (double)frame_size) * carriers.size();
+}
+
+ssize_t ToneInsertionMethod::frame_bits() const
+{
+  return carriers.size();
+}
+
+bool ToneInsertionMethod::independent_extraction() const
+{
+  return true;
+}
+
+template <typename T>
+ToneBins<T>::ToneBins(aligned_vector<T>& frame,
+                      double samplerate,
+                      const std::vector<ToneCarrier>& carriers)
+    : fft(frame.size(), frame, dft)
+{
+  auto add_bin = [&](double freq) {
+    unsigned bin = freq_to_bin(freq, samplerate, frame.size());
+    auto it = std::find(bins.begin(), bins.end(), bin);
+    if (it != bins.end())
+      return (std::size_t)std::distance(bins.begin(), it);
+    bins.push_back(bin);
+    return bins.size() - 1;
+  };
+
+  for (const auto& [freq0, freq1] : carriers) {
+    std::size_t bin0 = add_bin(freq0);
+    std::size_t bin1 = add_bin(freq1);
+    carrier_bins.push_back({bin0, bin1});
+  }
+  coefs.resize(bins.size());
+
+  // the Goertzel algorithm is O(N) for each bin, FFT is O(N log N) for all
+  use_fft = bins.size() > std::log2(frame.size());
+  if (use_fft) {
+    dft.resize(frame.size());
+  } else {
+    for (unsigned bin : bins) {
+      goertzel.emplace_back(frame.size(), bin, frame);
+    }
+  }
+}
+
+template <typename T>
+void ToneBins<T>::analyze()
+{
+  if (use_fft) {
+    fft.exec();
+    for (std::size_t i = 0; i < bins.size(); i++) {
+      coefs[i] = dft[bins[i]];
+    }
+  } else {
+    for (std::size_t i = 0; i < bins.size(); i++) {
+      coefs[i] = goertzel[i].exec();
+    }
+  }
+}
+
+template <typename T>
+void ToneBins<T>::analyze(const std::complex<T>* spectrum)
+{
+  for (std::size_t i = 0; i < bins.size(); i++) {
+    coefs[i] = spectrum[bins[i]];
+  }
+}
+
+/**
+ * @brief Create the complex exponential of a frequency bin.
+ * Inverse DFT of a spectrum with a unit coefficient in the given bin, and
+ * the complex conjugate one in the symmetric bin, is the real part of this
+ * exponential scaled by 2 / N. The DC and Nyquist bins have no symmetric
+ * counterpart and are scaled by 1 / N.
+ */
+template <typename T>
+static aligned_vector<std::complex<T>> make_tone(unsigned N, unsigned bin)
+{
+  const T scale = (bin == 0 || 2 * bin == N) ? 1.0 / N : 2.0 / N;
+
+  aligned_vector<std::complex<T>> tone(N);
+  for (std::size_t i = 0; i < N; i++) {
+    tone[i] = std::polar<T>(scale, 2 * M_PI * ((bin * i) % N) / N);
+  }
+  return tone;
 }
 
-ToneInsertionEmbedder::ToneInsertionEmbedder(InBitStream& data,
-                                             std::size_t frame_size,
-                                             double samplerate,
-                                             double freq_zero,
-                                             double freq_one)
-    : Embedder<double>(data, frame_size),
-      dft(in_frame.size()),
-      fft(in_frame.size(), in_frame, dft),
-      ifft(in_frame.size(), dft, out_frame),
-      bin_f0(freq_to_bin(freq_zero, samplerate, dft.size())),
-      bin_f1(freq_to_bin(freq_one, samplerate, dft.size()))
+template <typename T>
+ToneInsertionEmbedder<T>::ToneInsertionEmbedder(
+    InBitStream& data,
+    std::size_t frame_size,
+    double samplerate,
+    const std::vector<ToneCarrier>& carriers)
+    : Embedder<T>(data, frame_size),
+      bins(this->in_frame, samplerate, carriers),
+      new_coefs(bins.size()),
+      ifft(frame_size, bins.spectrum(), this->out_frame),
+      batch(frame_size, frame_size, frame_size, true)
 {
+  if (!bins.uses_fft()) {
+    for (std::size_t i = 0; i < bins.size(); i++) {
+      tones.push_back(make_tone<T>(frame_size, bins.bin(i)));
+    }
+  }
 }
 
-bool ToneInsertionEmbedder::embed()
+template <typename T>
+std::size_t ToneInsertionEmbedder<T>::insert_tones(T avg_pwr)
 {
-  double avg_pwr = avg_power(in_frame);
+  // the power is split among the carriers
+  T pwr = avg_pwr * EMBEDDING_PWR_PCT / bins.carriers();
+  T pwr_other = pwr * OTHER_PWR_PCT;
+  T magnitude = sqrt(pwr);
+  T magnitude_other = sqrt(pwr_other);
+
+  for (std::size_t i = 0; i < bins.size(); i++) {
+    new_coefs[i] = bins.coef(i);
+  }
+
+  // insert the tones
+  std::size_t carrier = 0;
+  for (; carrier < bins.carriers(); carrier++) {
+    int bit = this->data.next_bit();
+    if (bit == EOF)
+      break;
 
-  fft.exec();
+    const std::size_t f0 = bins.index(carrier, 0);
+    const std::size_t f1 = bins.index(carrier, 1);
+    T phase_f0 = std::arg(bins.coef(f0));
+    T phase_f1 = std::arg(bins.coef(f1));
+
+    if (bit) {
+      new_coefs[f1] = std::polar(magnitude, phase_f1);
+      new_coefs[f0] = std::polar(magnitude_other, phase_f0);
+    } else {
+      new_coefs[f0] = std::polar(magnitude, phase_f0);
+      new_coefs[f1] = std::polar(magnitude_other, phase_f1);
+    }
+  }
+  return carrier;
+}
 
-  // insert the tone
-  double phase_f0 = std::arg(dft[bin_f0]);
-  double phase_f1 = std::arg(dft[bin_f1]);
+template <typename T>
+bool ToneInsertionEmbedder<T>::embed()
+{
+  T avg_pwr = avg_power(this->in_frame);
 
-  double pwr = avg_pwr * EMBEDDING_PWR_PCT;
-  double pwr_other = pwr * OTHER_PWR_PCT;
-  double magnitude = sqrt(pwr);
-  double magnitude_other = sqrt(pwr_other);
+  bins.analyze();
+  const std::size_t carrier = insert_tones(avg_pwr);
 
-  int bit = data.next_bit();
-  if (bit == EOF) {
+  if (carrier == 0) {
+    std::copy(this->in_frame.begin(), this->in_frame.end(),
+              this->out_frame.begin());
     return true;
   }
-  if (bit) {
-    dft[bin_f1] = std::polar(magnitude, phase_f1);
-    dft[bin_f0] = std::polar(magnitude_other, phase_f0);
+
+  if (bins.uses_fft()) {
+    aligned_vector<std::complex<T>>& dft = bins.spectrum();
+    for (std::size_t i = 0; i < bins.size(); i++) {
+      dft[bins.bin(i)] = new_coefs[i];
+    }
+    ifft.exec();
   } else {
-    dft[bin_f0] = std::polar(magnitude, phase_f0);
-    dft[bin_f1] = std::polar(magnitude_other, phase_f1);
+    // add the change of the spectrum in time domain
+    std::copy(this->in_frame.begin(), this->in_frame.end(),
+              this->out_frame.begin());
+    for (std::size_t i = 0; i < bins.size(); i++) {
+      const std::complex<T> delta = new_coefs[i] - bins.coef(i);
+      const aligned_vector<std::complex<T>>& tone = tones[i];
+      for (std::size_t j = 0; j < this->out_frame.size(); j++) {
+        this->out_frame[j] += (delta * tone[j]).real();
+      }
+    }
+  }
+  return carrier < bins.carriers();
+}
+
+template <typename T>
+bool ToneInsertionEmbedder<T>::embed_frames(const PlanarBlock<T>& block)
+{
+  // the Goertzel algorithm is cheaper than FFT for the few bins
+  if (!bins.uses_fft())
+    return Embedder<T>::embed_frames(block);
+
+  const std::size_t frame_size = this->frame_size();
+  const unsigned count = block.count();
+  batch.forward(block.data(), count);
+
+  // only the frames up to the last one with embedded bits are modified
+  bool done = false;
+  unsigned modified = 0;
+  for (unsigned i = 0; i < count && !done; i++) {
+    std::complex<T>* dft = batch.spectrum(i);
+    bins.analyze(dft);
+    const std::size_t carrier =
+        insert_tones(avg_power(batch.frame(i), frame_size));
+    if (carrier == 0)
+      break;
+
+    for (std::size_t k = 0; k < bins.size(); k++) {
+      dft[bins.bin(k)] = new_coefs[k];
+    }
+    modified = i + 1;
+    done = carrier < bins.carriers();
   }
+  done |= modified < count;
 
-  ifft.exec();
-  return false;
+  batch.inverse(block.data(), modified);
+  return done;
 }
 
-ToneInsertionExtractor::ToneInsertionExtractor(std::size_t frame_size,
-                                               double samplerate,
-                                               double freq_zero,
-                                               double freq_one)
-    : Extractor<double>(frame_size),
-      dft(in_frame.size()),
-      fft(in_frame.size(), in_frame, dft),
-      bin_f0(freq_to_bin(freq_zero, samplerate, dft.size())),
-      bin_f1(freq_to_bin(freq_one, samplerate, dft.size()))
+template <typename T>
+ToneInsertionExtractor<T>::ToneInsertionExtractor(
+    std::size_t frame_size,
+    double samplerate,
+    const std::vector<ToneCarrier>& carriers)
+    : Extractor<T>(frame_size),
+      bins(this->in_frame, samplerate, carriers),
+      batch(frame_size, frame_size, frame_size, false)
 {
 }
 
-bool ToneInsertionExtractor::extract(OutBitStream& data)
+template <typename T>
+bool ToneInsertionExtractor<T>::extract(OutBitStream& data)
 {
-  double avg_pwr = avg_power(in_frame);
+  T avg_pwr = avg_power(this->in_frame);
 
-  fft.exec();
+  bins.analyze();
+  decode(avg_pwr, data);
+  return true;
+}
 
-  double p0 = std::norm(dft[bin_f0]);
-  double p1 = std::norm(dft[bin_f1]);
+template <typename T>
+bool ToneInsertionExtractor<T>::extract_frames(
+    const PlanarBlock<const T>& block,
+    OutBitStream& data)
+{
+  // the Goertzel algorithm is cheaper than FFT for the few bins
+  if (!bins.uses_fft())
+    return Extractor<T>::extract_frames(block, data);
 
-  char bit = (avg_pwr / p0) > (avg_pwr / p1);
-  data.output_bit(bit);
+  const unsigned count = block.count();
+  batch.forward(block.data(), count);
+  for (unsigned i = 0; i < count; i++) {
+    if (data.eof())
+      return false;
+    bins.analyze(batch.spectrum(i));
+    decode(avg_power(batch.frame(i), this->frame_size()), data);
+  }
   return true;
 }
+
+template <typename T>
+void ToneInsertionExtractor<T>::decode(T avg_pwr, OutBitStream& data)
+{
+  for (std::size_t carrier = 0; carrier < bins.carriers(); carrier++) {
+    T p0 = std::norm(bins.coef(bins.index(carrier, 0)));
+    T p1 = std::norm(bins.coef(bins.index(carrier, 1)));
+
+    char bit = (avg_pwr / p0) > (avg_pwr / p1);
+    data.output_bit(bit);
+  }
+}
+
+template class ToneBins<double>;
+template class ToneBins<float>;
+template class ToneInsertionEmbedder<double>;
+template class ToneInsertionEmbedder<float>;
+template class ToneInsertionExtractor<double>;
+template class ToneInsertionExtractor<float>;
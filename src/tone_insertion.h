@@ -21,62 +21,174 @@
 #ifndef TONE_INSERTION_H
 #define TONE_INSERTION_H
 
+#include <array>
+#include <complex>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
+#include "channel_batch.h"
 #include "embedder.h"
 #include "extractor.h"
 #include "fft.h"
+#include "goertzel.h"
 #include "ifft.h"
 #include "methods.h"
 
+/**
+ * @brief A carrier of one bit, a pair of frequencies for bits 0 and 1.
+ */
+using ToneCarrier = std::pair<unsigned, unsigned>;
+
 class ToneInsertionMethod : public Method {
  public:
   ToneInsertionMethod(const Params& params);
   embedder_variant make_embedder(InBitStream& input) const override;
   extractor_variant make_extractor() const override;
   virtual ssize_t capacity(std::size_t samples) const override;
+  virtual ssize_t frame_bits() const override;
+  virtual bool independent_extraction() const override;
 
  protected:
   std::size_t frame_size;
-  unsigned freq0;
-  unsigned freq1;
+  std::vector<ToneCarrier> carriers;
   unsigned samplerate;
+  bool single;
+};
+
+/**
+ * @brief The DFT coefficients of the frequency bins of tone carriers.
+ *
+ * The coefficients are computed with the Goertzel algorithm when there are
+ * only a few bins, otherwise with FFT.
+ * @tparam T The precision of the samples, double or float.
+ */
+template <typename T>
+class ToneBins {
+ public:
+  /**
+   * @brief Constructor.
+   * @param frame The frame to analyze.
+   * @param samplerate The sampling frequency.
+   * @param carriers The carriers to analyze.
+   */
+  ToneBins(aligned_vector<T>& frame,
+           double samplerate,
+           const std::vector<ToneCarrier>& carriers);
+
+  /**
+   * @brief Compute the coefficients of the current frame.
+   */
+  void analyze();
+
+  /**
+   * @brief Take the coefficients from the spectrum of a frame.
+   * @param spectrum The spectrum computed by FFT.
+   */
+  void analyze(const std::complex<T>* spectrum);
+
+  /**
+   * @brief Get the index of the bin of the given carrier and bit.
+   * Carriers may share bins, the indices are unique for each bin.
+   */
+  std::size_t index(std::size_t carrier, int bit) const
+  {
+    return carrier_bins[carrier][bit];
+  }
+
+  /**
+   * @brief Get the frequency bin with the given index.
+   */
+  unsigned bin(std::size_t index) const { return bins[index]; }
+
+  /**
+   * @brief Get the coefficient of the bin with the given index.
+   */
+  std::complex<T> coef(std::size_t index) const { return coefs[index]; }
+
+  /**
+   * @brief Get the number of distinct bins.
+   */
+  std::size_t size() const { return bins.size(); }
+
+  /**
+   * @brief Get the number of carriers.
+   */
+  std::size_t carriers() const { return carrier_bins.size(); }
+
+  /**
+   * @brief Whether the coefficients are computed with FFT.
+   */
+  bool uses_fft() const { return use_fft; }
+
+  /**
+   * @brief Get the whole spectrum of the frame, valid only if FFT is used.
+   */
+  aligned_vector<std::complex<T>>& spectrum() { return dft; }
+
+ private:
+  std::vector<unsigned> bins;
+  std::vector<std::array<std::size_t, 2>> carrier_bins;
+  aligned_vector<std::complex<T>> coefs;
+
+  bool use_fft;
+  std::vector<Goertzel<T>> goertzel;
+  aligned_vector<std::complex<T>> dft;
+  FFT<T> fft;
 };
 
-class ToneInsertionEmbedder : public Embedder<double> {
+template <typename T>
+class ToneInsertionEmbedder : public Embedder<T> {
  public:
   ToneInsertionEmbedder(InBitStream& data,
                         std::size_t frame_size,
                         double samplerate,
-                        double freq_zero,
-                        double freq_one);
+                        const std::vector<ToneCarrier>& carriers);
 
   bool embed() override;
 
+  bool embed_frames(const PlanarBlock<T>& block) override;
+
  private:
-  std::vector<std::complex<double>> dft;
-  FFT fft;
-  IFFT ifft;
+  /**
+   * @brief Compute the new coefficients of the analyzed frame.
+   * @param avg_pwr The average power of the frame.
+   * @return The number of carriers with embedded bits.
+   */
+  std::size_t insert_tones(T avg_pwr);
+
+  ToneBins<T> bins;
+  aligned_vector<std::complex<T>> new_coefs;
 
-  int bin_f0;
-  int bin_f1;
+  // the complex exponentials of the frequency bins, if FFT is not used
+  std::vector<aligned_vector<std::complex<T>>> tones;
+  IFFT<T> ifft;
+
+  ChannelBatch<T> batch;
 };
 
-class ToneInsertionExtractor : public Extractor<double> {
+template <typename T>
+class ToneInsertionExtractor : public Extractor<T> {
  public:
   ToneInsertionExtractor(std::size_t frame_size,
                          double samplerate,
-                         double freq_zero,
-                         double freq_one);
+                         const std::vector<ToneCarrier>& carriers);
 
   bool extract(OutBitStream& data) override;
 
+  bool extract_frames(const PlanarBlock<const T>& block,
+                      OutBitStream& data) override;
+
  private:
-  std::vector<std::complex<double>> dft;
-  FFT fft;
+  /**
+   * @brief Extract the bits of the analyzed frame.
+   * @param avg_pwr The average power of the frame.
+   */
+  void decode(T avg_pwr, OutBitStream& data);
+
+  ToneBins<T> bins;
 
-  int bin_f0;
-  int bin_f1;
+  ChannelBatch<T> batch;
 };
 
 #endif
@@ -0,0 +1,88 @@
+#!/bin/bash
+
+# Script comparing the double and single precision of the frequency-domain
+# methods
+#
+# Every cover is embedded into with precision=double and precision=float, for
+# each precision the SNR of the stego file and the BER of the extracted
+# message are printed, with the largest difference of the samples of the two
+# stego files in the LSBs of 16-bit samples. The results should be the same up
+# to a difference of the samples of one LSB.
+#
+# Requires ber, snr and sample_diff, see Makefile.
+
+BIN=${BIN:-"../build/src/stego"}
+METHODS=${METHODS:-"phase echo echo-hc tone"}
+_ARGS=${ARGS:-}
+
+COVERS_DIR=$1
+OUTPUT_DIR=$2
+MSG_FILE=$3
+
+# embed and extract with the precision, print the SNR and BER
+test_precision() {
+    local method=$1
+    local cover=$2
+    local test_dir=$3
+    local precision=$4
+    local params="precision=$precision${PARAMS:+,$PARAMS}"
+
+    local stego="$test_dir/$precision.wav"
+    local extracted="$test_dir/$precision.txt"
+
+    if ! "$BIN" embed -m "$method" -cf "$cover" -sf "$stego" $_ARGS -k "$params" \
+        < "$MSG_FILE" 2> "$test_dir/$precision.stderr.txt";
+    then
+        echo 1>&2 "Failed to embed to cover: $cover"
+        return 1
+    fi
+    if ! "$BIN" extract -m "$method" -sf "$stego" $_ARGS -k "$params" \
+        > "$extracted" 2>> "$test_dir/$precision.stderr.txt";
+    then
+        echo 1>&2 "Failed to extract from stego: $stego"
+        return 1
+    fi
+
+    echo -n "$(./snr -db "$cover" "$stego");$(./ber "$MSG_FILE" "$extracted")"
+}
+
+print_help() {
+    echo "Usage: compare_precision.sh COVERS_DIR OUTPUT_DIR MSG_FILE"
+    echo "The environment variables BIN, METHODS, PARAMS (the other stego keys)"
+    echo "and ARGS (the other arguments) override the defaults."
+}
+
+if [ "$1" = "--help" ]; then
+    print_help
+    exit 0
+fi
+
+if [ ! -d "$COVERS_DIR" ]; then
+    echo "COVERS_DIR must be a directory, see --help" 1>&2
+    exit 1
+fi
+
+if [ ! -d "$OUTPUT_DIR" ]; then
+    echo "OUTPUT_DIR must be a directory, see --help" 1>&2
+    exit 1
+fi
+
+echo "method;type;snr-double;ber-double;snr-float;ber-float;max-diff"
+for cover in "$COVERS_DIR"/*; do
+    type="${cover##*/}" # strip path
+    type=${type%-*}
+    for method in $METHODS; do
+        test_dir="$OUTPUT_DIR/${cover##*/}.out/$method-precision"
+        mkdir -p "$test_dir"
+
+        out="$method;$type"
+        for precision in double float; do
+            if ! result=$(test_precision "$method" "$cover" "$test_dir" "$precision"); then
+                continue 2
+            fi
+            out+=";$result"
+        done
+        out+=";$(./sample_diff "$test_dir/double.wav" "$test_dir/float.wav")"
+        echo "$out"
+    done
+done
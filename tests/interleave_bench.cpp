@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "interleave.h"
+
+// the samples in each channel, the default frame size of the methods
+#define FRAMES 4096
+#define DEF_REPEATS 2000
+
+// the levels up to the one of the CPU
+std::vector<SimdLevel> supported_levels() {
+  std::vector<SimdLevel> levels = {SimdLevel::SCALAR};
+  const SimdLevel best = simd_level();
+  for (SimdLevel level :
+       {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+    if (best >= level)
+      levels.push_back(level);
+  }
+  return levels;
+}
+
+// compare the level with the plain loops, including frame counts with tails
+template <typename T> bool check(SimdLevel level, int channels) {
+  for (size_t frames : {0, 1, 7, 37, FRAMES}) {
+    std::vector<T> in(frames * channels), planar(in.size()), ref(in.size()),
+        out(in.size());
+    for (size_t i = 0; i < in.size(); i++)
+      in[i] = static_cast<T>(rand() - RAND_MAX / 2);
+
+    for (size_t i = 0; i < frames; i++)
+      for (int ch = 0; ch < channels; ch++)
+        ref[ch * frames + i] = in[i * channels + ch];
+
+    deinterleave(in.data(), planar.data(), frames, channels, level);
+    if (planar != ref)
+      return false;
+    interleave(planar.data(), out.data(), frames, channels, level);
+    if (out != in)
+      return false;
+  }
+  return true;
+}
+
+// the time of a single conversion of all channels, in microseconds
+template <typename T>
+void bench(const char *type, SimdLevel level, int channels, int repeats) {
+  std::vector<T> in(FRAMES * channels), planar(in.size()), out(in.size());
+  for (size_t i = 0; i < in.size(); i++)
+    in[i] = static_cast<T>(i);
+
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  for (int r = 0; r < repeats; r++)
+    deinterleave(in.data(), planar.data(), FRAMES, channels, level);
+  const double d =
+      std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+  start = clock::now();
+  for (int r = 0; r < repeats; r++)
+    interleave(planar.data(), out.data(), FRAMES, channels, level);
+  const double i =
+      std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+  std::cout << std::setw(6) << type << std::setw(10) << simd_name(level)
+            << std::setw(4) << channels << std::fixed << std::setprecision(3)
+            << std::setw(14) << d / repeats << std::setw(14) << i / repeats
+            << std::endl;
+}
+
+template <typename T>
+bool run(const char *type, const std::vector<SimdLevel> &levels,
+         int repeats) {
+  for (int channels : {1, 2, 3, 4, 6, 8}) {
+    for (SimdLevel level : levels) {
+      if (!check<T>(level, channels)) {
+        std::cerr << "Mismatch: " << type << " " << simd_name(level) << " "
+                  << channels << " channels" << std::endl;
+        return false;
+      }
+      bench<T>(type, level, channels, repeats);
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc > 2) {
+    std::cerr << "Expected at most 1 argument, the number of repeats!"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int repeats = argc == 2 ? std::atoi(argv[1]) : DEF_REPEATS;
+  if (repeats <= 0) {
+    std::cerr << "Invalid number of repeats: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<SimdLevel> levels = supported_levels();
+  std::cout << "frames: " << FRAMES << ", cpu: " << simd_name(simd_level())
+            << std::endl;
+  std::cout << std::setw(6) << "type" << std::setw(10) << "kernel"
+            << std::setw(4) << "ch" << std::setw(14) << "deint [us]"
+            << std::setw(14) << "int [us]" << std::endl;
+
+  if (!run<int16_t>("int16", levels, repeats) ||
+      !run<int32_t>("int32", levels, repeats) ||
+      !run<float>("float", levels, repeats) ||
+      !run<double>("double", levels, repeats))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
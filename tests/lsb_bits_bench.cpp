@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include "lsb_bits.h"
+
+// the samples in each channel, the default frame size of the methods
+#define FRAMES 4096
+#define DEF_REPEATS 20000
+
+// keeps the extraction from being optimized out
+volatile uint64_t sink;
+
+// the kernels supported by the CPU, false for the portable loops
+std::vector<bool> supported_kernels() {
+  std::vector<bool> kernels = {false};
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("bmi2"))
+    kernels.push_back(true);
+#endif
+  return kernels;
+}
+
+const char *kernel_name(bool bmi2) { return bmi2 ? "bmi2" : "scalar"; }
+
+uint64_t random_bits() {
+  uint64_t bits = 0;
+  for (int i = 0; i < 4; i++)
+    bits = (bits << 16) ^ (rand() & 0xffff);
+  return bits;
+}
+
+// the substitution of the LSBs of a sample by the LSB method before the
+// kernels, the bit above the LSBs and the padding bits below are cleared
+template <typename T>
+T reference_deposit(T sample, unsigned bits, unsigned lsbs, unsigned shift) {
+  using U = typename std::make_unsigned<T>::type;
+  U s = sample;
+  s = s >> shift;
+  s &= ((unsigned)~1 << lsbs);
+  s |= bits;
+  return static_cast<T>(static_cast<U>(s << shift));
+}
+
+// compare the kernel with the reference for every number of LSBs and every
+// number of samples up to a word, including the tails of the 64-bit words
+template <typename T> bool check(bool bmi2, unsigned bit_depth) {
+  const unsigned shift = 8 * sizeof(T) - bit_depth;
+  for (unsigned lsbs = 1; lsbs < bit_depth; lsbs++) {
+    for (size_t n = 0; n * lsbs <= 64; n++) {
+      std::vector<T> in(n), out(n), ref(n);
+      for (size_t i = 0; i < n; i++)
+        in[i] = static_cast<T>(random_bits());
+      uint64_t bits = random_bits();
+      if (n * lsbs < 64)
+        bits &= ((uint64_t)1 << (n * lsbs)) - 1;
+
+      for (size_t i = 0; i < n; i++) {
+        const unsigned lsb = (bits >> (i * lsbs)) & ((1u << lsbs) - 1);
+        ref[i] = reference_deposit(in[i], lsb, lsbs, shift);
+      }
+
+      deposit_lsbs(in.data(), out.data(), n, bits, lsbs, shift, bmi2);
+      if (out != ref ||
+          extract_lsbs(out.data(), n, lsbs, shift, bmi2) != bits)
+        return false;
+      // in place
+      deposit_lsbs(in.data(), in.data(), n, bits, lsbs, shift, bmi2);
+      if (in != ref)
+        return false;
+    }
+  }
+  return true;
+}
+
+// the time of substituting and retrieving the LSBs of a frame, in
+// microseconds
+template <typename T>
+void bench(const char *type, bool bmi2, unsigned lsbs, int repeats) {
+  std::vector<T> samples(FRAMES);
+  for (size_t i = 0; i < samples.size(); i++)
+    samples[i] = static_cast<T>(i);
+  const size_t step = lsb_word_samples<T>(lsbs);
+  const uint64_t bits = random_bits();
+
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  for (int r = 0; r < repeats; r++)
+    for (size_t i = 0; i < FRAMES; i += step)
+      deposit_lsbs(samples.data() + i, samples.data() + i,
+                   std::min(step, FRAMES - i), bits, lsbs, 0, bmi2);
+  const double d =
+      std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+  uint64_t sum = 0;
+  start = clock::now();
+  for (int r = 0; r < repeats; r++)
+    for (size_t i = 0; i < FRAMES; i += step)
+      sum += extract_lsbs(samples.data() + i, std::min(step, FRAMES - i), lsbs,
+                          0, bmi2);
+  const double e =
+      std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+  sink = sum;
+  std::cout << std::setw(6) << type << std::setw(8) << kernel_name(bmi2)
+            << std::setw(6) << lsbs << std::fixed << std::setprecision(3)
+            << std::setw(14) << d / repeats << std::setw(14) << e / repeats
+            << std::endl;
+}
+
+template <typename T>
+bool run(const char *type, const std::vector<bool> &kernels,
+         std::initializer_list<unsigned> bit_depths, int repeats) {
+  for (bool bmi2 : kernels) {
+    for (unsigned bit_depth : bit_depths) {
+      if (!check<T>(bmi2, bit_depth)) {
+        std::cerr << "Mismatch: " << type << " " << kernel_name(bmi2)
+                  << " bit depth " << bit_depth << std::endl;
+        return false;
+      }
+    }
+  }
+  for (unsigned lsbs : {1, 2, 4})
+    for (bool bmi2 : kernels)
+      bench<T>(type, bmi2, lsbs, repeats);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc > 2) {
+    std::cerr << "Expected at most 1 argument, the number of repeats!"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int repeats = argc == 2 ? std::atoi(argv[1]) : DEF_REPEATS;
+  if (repeats <= 0) {
+    std::cerr << "Invalid number of repeats: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<bool> kernels = supported_kernels();
+  std::cout << "frames: " << FRAMES
+            << ", used: " << kernel_name(lsb_bmi2()) << std::endl;
+  std::cout << std::setw(6) << "type" << std::setw(8) << "kernel"
+            << std::setw(6) << "lsbs" << std::setw(14) << "deposit [us]"
+            << std::setw(14) << "extract [us]" << std::endl;
+
+  if (!run<int16_t>("int16", kernels, {4, 8, 12, 16}, repeats) ||
+      !run<int32_t>("int32", kernels, {20, 24, 32}, repeats))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <sndfile.hh>
+
+#define BUFFER_SIZE 4096
+
+// the largest difference of the samples, in the LSBs of 16-bit samples
+int max_difference(SndfileHandle &ref, SndfileHandle &in) {
+  std::vector<short> buff_ref(BUFFER_SIZE * ref.channels());
+  std::vector<short> buff_in(BUFFER_SIZE * in.channels());
+
+  int max_diff = 0;
+  while (1) {
+    sf_count_t read_ref = ref.readf(buff_ref.data(), BUFFER_SIZE);
+    sf_count_t read_in = in.readf(buff_in.data(), BUFFER_SIZE);
+    if (read_ref != read_in) {
+      std::cerr << "Files are not the same length!\n";
+      return -1;
+    }
+    if (read_ref <= 0)
+      break;
+
+    for (sf_count_t i = 0; i < read_ref * ref.channels(); i++) {
+      max_diff = std::max(max_diff, std::abs(buff_in[i] - buff_ref[i]));
+    }
+  }
+  return max_diff;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc != 3) {
+    std::cerr << "Expected 2 arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  SndfileHandle ref{argv[1], SFM_READ};
+  if (!ref) {
+    std::cerr << "Failed to open file " << argv[1] << ": ";
+    std::cerr << ref.strError() << std::endl;
+    return EXIT_FAILURE;
+  }
+  SndfileHandle in{argv[2], SFM_READ};
+  if (!in) {
+    std::cerr << "Failed to open file " << argv[2] << ": ";
+    std::cerr << in.strError() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (ref.channels() != in.channels()) {
+    std::cerr << "Files have different number of channels!\n";
+    return EXIT_FAILURE;
+  }
+
+  int diff = max_difference(ref, in);
+  if (diff < 0)
+    return EXIT_FAILURE;
+  std::cout << diff << std::endl;
+  return EXIT_SUCCESS;
+}